@@ -9,8 +9,22 @@ ROOT.gROOT.SetBatch(True)
 
 source = "/store/user/rasharma/SecondStep/WWTree_2017-11-26_18h59/HaddedFiles/"
 
-with os.popen('xrdfs root://cmseos.fnal.gov ls '+source) as pipe:
-	for line in pipe:
-		#print line.strip()
-		print ('root -l -b -q TMVAClassificationApplication.C'+'\(\\"'+line.strip()+'\\"\)')
-		os.system('root -l -b -q TMVAClassificationApplication.C'+'\(\\"'+'root://cmsxrootd.fnal.gov/'+line.strip()+'\\"\)')
+# Number of threads for TMVAApplicationDriver; default all cores of the node
+nthreads = sys.argv[1] if len(sys.argv) > 1 else str(os.sysconf('SC_NPROCESSORS_ONLN'))
+# Optional directory (local or root://) the outputs are copied to as soon as they are written;
+# the remote inputs go through the block cache in $TMVA_CACHEDIR when it is set (TMVARemoteIO.h)
+uploaddir = sys.argv[2] if len(sys.argv) > 2 else ''
+
+# All files go to one TMVAApplicationDriver process, which loads the weights once
+# and spreads files and entry ranges over its threads
+with open('RunAllFiles.list','w') as filelist:
+	with os.popen('xrdfs root://cmseos.fnal.gov ls '+source) as pipe:
+		for line in pipe:
+			#print line.strip()
+			filelist.write('root://cmsxrootd.fnal.gov/'+line.strip()+'\n')
+
+if not os.path.exists('TMVAApplicationDriver'):
+	os.system('g++ -O2 TMVAApplicationDriver.C $(root-config --cflags --libs) -lTMVA -lXMLIO -lTreePlayer -o TMVAApplicationDriver')
+command = './TMVAApplicationDriver -j '+nthreads+(' -u '+uploaddir if uploaddir else '')+' @RunAllFiles.list'
+print (command)
+sys.exit(subprocess.call(command, shell=True))
@@ -0,0 +1,99 @@
+#ifndef _TMVAAPPIO_H_
+#define _TMVAAPPIO_H_
+
+// Input/output helpers for the application step.
+//
+// - weightexpressions : the <Variables> and <Spectators> expressions of a weight file
+// - exprbranches      : the branches of a tree referenced by a set of expressions
+// - prunebranches     : disable every other branch, so only the needed baskets are read
+// - MVAFriend         : a small tree with one entry per input entry (same order) holding the
+//                       responses, to be used with otree->AddFriend("mvatree", "output.root")
+
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TXMLEngine.h"
+
+namespace mytmva
+{
+  inline std::vector<std::string> weightexpressions(std::string weightfile)
+  {
+    std::vector<std::string> exprs;
+    TXMLEngine xml;
+    XMLDocPointer_t doc = xml.ParseFile(weightfile.c_str());
+    if(!doc) { std::cout << "==> Abort " << __FUNCTION__ << ": error: cannot parse weight file " << weightfile << std::endl; return exprs; }
+    XMLNodePointer_t setup = xml.DocGetRootElement(doc);
+    for(XMLNodePointer_t node = xml.GetChild(setup); node; node = xml.GetNext(node))
+      {
+        std::string name = xml.GetNodeName(node);
+        if(name != "Variables" && name != "Spectators") continue;
+        for(XMLNodePointer_t v = xml.GetChild(node); v; v = xml.GetNext(v))
+          { exprs.push_back(xml.GetAttr(v, "Expression")); }
+      }
+    xml.FreeDoc(doc);
+    return exprs;
+  }
+
+  inline std::vector<std::string> exprbranches(TTree* t, const std::vector<std::string>& exprs)
+  {
+    std::vector<std::string> branches;
+    for(auto& e : exprs)
+      {
+        for(std::size_t i=0; i<e.size(); )
+          {
+            if(!(std::isalpha(e[i]) || e[i] == '_')) { i++; continue; }
+            std::size_t j = i;
+            while(j < e.size() && (std::isalnum(e[j]) || e[j] == '_')) { j++; }
+            std::string tok = e.substr(i, j-i);
+            if(t->GetBranch(tok.c_str()) && std::find(branches.begin(), branches.end(), tok) == branches.end())
+              { branches.push_back(tok); }
+            i = j;
+          }
+      }
+    return branches;
+  }
+
+  inline void prunebranches(TTree* t, const std::vector<std::string>& branches)
+  {
+    t->SetBranchStatus("*", 0);
+    for(auto& b : branches) { t->SetBranchStatus(b.c_str(), 1); }
+  }
+
+  class MVAFriend
+  {
+  public:
+    MVAFriend(const std::vector<std::string>& methods) : fresponse(methods.size(), 0), fbdt(0), fentry(0)
+    {
+      ftree = new TTree("mvatree", "MVA responses, one entry per otree entry");
+      ftree->Branch("entry", &fentry);
+      ftree->Branch("BDT_response", &fbdt);
+      for(std::size_t im=0; im<methods.size(); im++)
+        {
+          ftree->Branch(("MVA_" + methods[im]).c_str(), &fresponse[im]);
+          if(methods[im] == "BDTG") fibdtg = im;
+        }
+    }
+    TTree* tree() { return ftree; }
+    // fill the responses of input entry ientry; entries must come in input order
+    void fill(Long64_t ientry, const float* response)
+    {
+      fentry = ientry;
+      for(std::size_t im=0; im<fresponse.size(); im++) { fresponse[im] = response[im]; }
+      fbdt = fibdtg >= 0 ? fresponse[fibdtg] : 0;
+      ftree->Fill();
+    }
+  private:
+    TTree* ftree;
+    std::vector<Float_t> fresponse;
+    Float_t fbdt;
+    Long64_t fentry;
+    int fibdtg = -1;
+  };
+}
+
+#endif
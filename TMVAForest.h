@@ -0,0 +1,269 @@
+#ifndef _TMVAFOREST_H_
+#define _TMVAFOREST_H_
+
+// Flat, block-vectorized evaluation of TMVA BDT weight files (BDT, BDTG, BDTB, BDTD, BDTF).
+//
+// The forest of a weights.xml is loaded once and flattened into structure-of-arrays node
+// tables. Events are scored in blocks laid out column-major, x[ivar*nevt + ievt], so the
+// inner loops run over events and can be vectorized by the compiler.
+// The response is the same as TMVA::Reader::EvaluateMVA (MethodBDT::GetMvaValue).
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "TString.h"
+#include "TXMLEngine.h"
+
+namespace mytmva
+{
+  class BDTForest
+  {
+  public:
+    BDTForest(std::string weightfile);
+
+    bool isvalid() const { return fvalid; }
+    std::string method() const { return fmethod; }
+    int nvar() const { return fvars.size(); }
+    const std::vector<std::string>& variables() const { return fvars; }
+    const std::vector<std::string>& spectators() const { return fspecs; }
+    int ntrees() const { return froot.size(); }
+
+    // x : column-major block of nevt events, x[ivar*nevt + ievt], variables in weight file order
+    // out : nevt responses
+    void evaluate(const float* x, int nevt, float* out) const;
+    // single event, variables in weight file order
+    float evaluate(const float* x) const { float out; evaluate(x, 1, &out); return out; }
+
+  private:
+    bool fvalid;
+    std::string fmethod;
+    std::vector<std::string> fvars;
+    std::vector<std::string> fspecs;
+    bool fgrad;
+    bool fyesnoleaf;
+    double fnorm;
+
+    // node tables; leaves point to themselves so every tree can be walked a fixed number of steps
+    std::vector<int> fnodevar;    // input column, nvar + k for the k-th Fisher node
+    std::vector<float> fnodecut;
+    std::vector<int> fnodeleft;   // child for x < cut
+    std::vector<int> fnoderight;  // child for x >= cut
+    std::vector<double> fnodeleaf; // leaf value, boost weight folded in
+    // tree tables
+    std::vector<int> froot;
+    std::vector<int> fdepth;
+    // Fisher cuts (BDTF): column nvar + k is 1 if offset + coeff.x > cut, else 0
+    std::vector<std::vector<double>> ffishercoeff;
+    std::vector<float> ffishercut;
+    // VarTransform=Decorrelate (BDTD)
+    std::vector<double> fdecorr;
+
+    int readnode(TXMLEngine& xml, XMLNodePointer_t node, double boostweight, int depth, int& maxdepth);
+    void abort(std::string msg) { std::cout << "==> Abort mytmva::BDTForest: error: " << msg << std::endl; fvalid = false; }
+  };
+}
+
+inline mytmva::BDTForest::BDTForest(std::string weightfile) : fvalid(true), fgrad(false), fyesnoleaf(true), fnorm(0)
+{
+  TXMLEngine xml;
+  XMLDocPointer_t doc = xml.ParseFile(weightfile.c_str());
+  if(!doc) { abort("cannot parse weight file " + weightfile); return; }
+  XMLNodePointer_t setup = xml.DocGetRootElement(doc);
+  fmethod = xml.HasAttr(setup, "Method") ? xml.GetAttr(setup, "Method") : "";
+  if(fmethod.find("BDT::") != 0) { abort("not a BDT weight file " + weightfile); xml.FreeDoc(doc); return; }
+
+  for(XMLNodePointer_t node = xml.GetChild(setup); node && fvalid; node = xml.GetNext(node))
+    {
+      std::string name = xml.GetNodeName(node);
+      if(name == "Options")
+        {
+          for(XMLNodePointer_t opt = xml.GetChild(node); opt; opt = xml.GetNext(opt))
+            {
+              std::string oname = xml.GetAttr(opt, "name");
+              std::string oval = xml.GetNodeContent(opt) ? xml.GetNodeContent(opt) : "";
+              if(oname == "BoostType") { fgrad = (oval == "Grad"); }
+              if(oname == "UseYesNoLeaf") { fyesnoleaf = (oval == "True" || oval == "T" || oval == "1"); }
+            }
+        }
+      else if(name == "Variables")
+        {
+          for(XMLNodePointer_t v = xml.GetChild(node); v; v = xml.GetNext(v))
+            { fvars.push_back(xml.GetAttr(v, "Expression")); }
+        }
+      else if(name == "Spectators")
+        {
+          for(XMLNodePointer_t v = xml.GetChild(node); v; v = xml.GetNext(v))
+            { fspecs.push_back(xml.GetAttr(v, "Expression")); }
+        }
+      else if(name == "Transformations")
+        {
+          for(XMLNodePointer_t trf = xml.GetChild(node); trf; trf = xml.GetNext(trf))
+            {
+              std::string tname = xml.GetAttr(trf, "Name");
+              if(tname != "Decorrelation") { abort("unsupported variable transformation " + tname); break; }
+              // one matrix per class followed by the one for all classes, which the Reader applies
+              XMLNodePointer_t mat = 0;
+              for(XMLNodePointer_t c = xml.GetChild(trf); c; c = xml.GetNext(c))
+                { if(std::string(xml.GetNodeName(c)) == "Matrix") { mat = c; } }
+              if(!mat) { abort("decorrelation without matrix"); break; }
+              int nrow = xml.GetIntAttr(mat, "Rows"), ncol = xml.GetIntAttr(mat, "Columns");
+              if(nrow != (int)fvars.size() || ncol != (int)fvars.size()) { abort("decorrelation of a subset of variables"); break; }
+              std::vector<double> m(nrow*ncol);
+              const char* content = xml.GetNodeContent(mat);
+              char* end = 0;
+              for(int i=0; i<nrow*ncol && content; i++) { m[i] = std::strtod(content, &end); content = end; }
+              if(!fdecorr.empty()) { abort("more than one variable transformation"); break; }
+              fdecorr = m;
+            }
+        }
+      else if(name == "Weights")
+        {
+          for(XMLNodePointer_t tree = xml.GetChild(node); tree && fvalid; tree = xml.GetNext(tree))
+            {
+              double boostweight = fgrad ? 1. : xml.GetAttr(tree, "boostWeight") ? std::atof(xml.GetAttr(tree, "boostWeight")) : 1.;
+              fnorm += boostweight;
+              int maxdepth = 0;
+              froot.push_back(readnode(xml, xml.GetChild(tree), boostweight, 0, maxdepth));
+              fdepth.push_back(maxdepth);
+            }
+        }
+    }
+  xml.FreeDoc(doc);
+
+  // Fisher columns index after the input variables
+  for(std::size_t i=0; i<fnodevar.size(); i++)
+    { if(fnodevar[i] < 0) { fnodevar[i] = fvars.size() + (-fnodevar[i] - 1); } }
+  if(fvalid && froot.empty()) { abort("no trees in " + weightfile); }
+  if(fvalid)
+    { std::cout << "==> mytmva::BDTForest: Loaded " << fmethod << " with " << froot.size() << " trees, " << fnodevar.size() << " nodes from " << weightfile << std::endl; }
+}
+
+inline int mytmva::BDTForest::readnode(TXMLEngine& xml, XMLNodePointer_t node, double boostweight, int depth, int& maxdepth)
+{
+  if(!node) { abort("empty tree"); return 0; }
+  int inode = fnodevar.size();
+  fnodevar.push_back(0);
+  fnodecut.push_back(0);
+  fnodeleft.push_back(inode);
+  fnoderight.push_back(inode);
+  fnodeleaf.push_back(0);
+
+  int ntype = xml.GetIntAttr(node, "nType");
+  if(ntype != 0)
+    {
+      double leaf = fgrad ? std::atof(xml.GetAttr(node, "res")) : fyesnoleaf ? (double)ntype : (double)(float)std::atof(xml.GetAttr(node, "purity"));
+      fnodeleaf[inode] = boostweight * (fgrad ? (double)(float)leaf : leaf);
+      maxdepth = std::max(maxdepth, depth);
+      return inode;
+    }
+
+  XMLNodePointer_t left = 0, right = 0;
+  for(XMLNodePointer_t c = xml.GetChild(node); c; c = xml.GetNext(c))
+    {
+      std::string pos = xml.GetAttr(c, "pos");
+      if(pos == "l") left = c;
+      if(pos == "r") right = c;
+    }
+  if(!left || !right) { abort("intermediate node without two daughters"); return inode; }
+
+  float cut = std::atof(xml.GetAttr(node, "Cut"));
+  bool ctype = xml.GetIntAttr(node, "cType");
+  int ncoef = xml.HasAttr(node, "NCoef") ? xml.GetIntAttr(node, "NCoef") : 0;
+  if(ncoef > 0)
+    {
+      std::vector<double> coeff(ncoef);
+      for(int i=0; i<ncoef; i++) { coeff[i] = std::atof(xml.GetAttr(node, Form("fC%d", i))); }
+      ffishercoeff.push_back(coeff);
+      ffishercut.push_back(cut);
+      fnodevar[inode] = -(int)ffishercoeff.size();
+      cut = 0.5;
+    }
+  else
+    { fnodevar[inode] = xml.GetIntAttr(node, "IVar"); }
+  fnodecut[inode] = cut;
+
+  int ileft = readnode(xml, left, boostweight, depth+1, maxdepth);
+  int iright = readnode(xml, right, boostweight, depth+1, maxdepth);
+  // cType==0 means the cut selects background: the daughters swap roles
+  fnodeleft[inode] = ctype ? ileft : iright;
+  fnoderight[inode] = ctype ? iright : ileft;
+  return inode;
+}
+
+inline void mytmva::BDTForest::evaluate(const float* x, int nevt, float* out) const
+{
+  int nv = fvars.size();
+  int ncol = nv + ffishercoeff.size();
+  std::vector<float> cols;
+  const float* in = x;
+  if(!fdecorr.empty() || !ffishercoeff.empty())
+    {
+      cols.assign((std::size_t)ncol*nevt, 0);
+      if(fdecorr.empty()) { std::copy(x, x + (std::size_t)nv*nevt, cols.begin()); }
+      else
+        {
+          std::vector<double> acc(nevt);
+          for(int j=0; j<nv; j++)
+            {
+              std::fill(acc.begin(), acc.end(), 0.);
+              for(int k=0; k<nv; k++)
+                {
+                  double m = fdecorr[j*nv + k];
+                  const float* xk = x + (std::size_t)k*nevt;
+                  for(int i=0; i<nevt; i++) { acc[i] += m * xk[i]; }
+                }
+              for(int i=0; i<nevt; i++) { cols[(std::size_t)j*nevt + i] = acc[i]; }
+            }
+        }
+      for(std::size_t f=0; f<ffishercoeff.size(); f++)
+        {
+          const std::vector<double>& c = ffishercoeff[f];
+          std::vector<double> acc(nevt, c.back());
+          for(int k=0; k<(int)c.size()-1; k++)
+            {
+              const float* xk = &cols[(std::size_t)k*nevt];
+              for(int i=0; i<nevt; i++) { acc[i] += c[k] * xk[i]; }
+            }
+          float* xf = &cols[(std::size_t)(nv+f)*nevt];
+          for(int i=0; i<nevt; i++) { xf[i] = acc[i] > ffishercut[f] ? 1.f : 0.f; }
+        }
+      in = &cols[0];
+    }
+
+  const int* nodevar = &fnodevar[0];
+  const float* nodecut = &fnodecut[0];
+  const int* nodeleft = &fnodeleft[0];
+  const int* noderight = &fnoderight[0];
+  const double* nodeleaf = &fnodeleaf[0];
+
+  std::vector<double> sum(nevt, 0.);
+  std::vector<int> idx(nevt);
+  for(std::size_t t=0; t<froot.size(); t++)
+    {
+      std::fill(idx.begin(), idx.end(), froot[t]);
+      for(int d=0; d<fdepth[t]; d++)
+        {
+          for(int i=0; i<nevt; i++)
+            {
+              int n = idx[i];
+              idx[i] = in[(std::size_t)nodevar[n]*nevt + i] >= nodecut[n] ? noderight[n] : nodeleft[n];
+            }
+        }
+      for(int i=0; i<nevt; i++) { sum[i] += nodeleaf[idx[i]]; }
+    }
+
+  if(fgrad)
+    { for(int i=0; i<nevt; i++) { out[i] = 2.0/(1.0+std::exp(-2.0*sum[i]))-1; } }
+  else
+    {
+      double norm = fnorm > std::numeric_limits<double>::epsilon() ? fnorm : 0;
+      for(int i=0; i<nevt; i++) { out[i] = norm ? sum[i]/norm : 0; }
+    }
+}
+
+#endif
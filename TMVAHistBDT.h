@@ -0,0 +1,563 @@
+#ifndef _TMVAHISTBDT_H_
+#define _TMVAHISTBDT_H_
+
+// Histogram-based, multi-threaded gradient boosting (BoostType=Grad) writing a TMVA BDT weight file.
+//
+// Every variable is quantized once into at most nCuts+1 quantile bins, kept as one byte per event.
+// Node splits are then found from per-bin histograms of the gradient and weight sums, filled in
+// parallel over the variables; the larger daughter's histograms are the parent's minus the smaller
+// one's. The boosting follows TMVA MethodBDT::GradBoost: binomial log-likelihood with residuals
+// r = y - 1/(1+exp(-2F)), splits on the weighted variance of r, and leaf responses
+// Shrinkage/2 * sum(w r) / sum(w |r| (1-|r|)). The weight file has the layout of
+// MethodBDT::AddWeightsXMLTo, so TMVA::Reader and mytmva::BDTForest read it unchanged.
+//
+// Differences to MethodBDT: the cut candidates are the global quantile edges rather than an
+// equidistant grid between each node's minimum and maximum, and the leaf denominator uses w
+// instead of w*w.
+//
+// Options (TMVA syntax): NTrees, MaxDepth, MinNodeSize, nCuts, Shrinkage, UseBaggedBoost,
+// BaggedSampleFraction, NegWeightTreatment (Pray, IgnoreNegWeightsInTraining; InverseBoostNegWeights
+// is replaced by Pray as in TMVA); BoostType must be Grad. All options are copied to the weight file.
+// As DataLoader "NormMode=NumEvents:SplitMode=Random", the training weights are scaled to an average
+// of 1 per class and the events are split at random into a training and a test sample.
+
+#ifdef __CLING__
+#pragma cling optimize(3)
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <ctime>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TROOT.h"
+#include "TString.h"
+#include "TSystem.h"
+#include "TTree.h"
+#include "TTreeFormula.h"
+#include "TXMLEngine.h"
+#include "TMVA/Version.h"
+
+#include "TMVATrainData.h"
+
+namespace mytmva
+{
+  // fn(begin, end) on nthreads contiguous ranges of [0, n)
+  template<class F> void parallelrange(std::size_t n, int nthreads, F fn)
+  {
+    if(nthreads <= 1 || n < 1024) { fn((std::size_t)0, n); return; }
+    std::vector<std::thread> threads;
+    for(int t=0; t<nthreads; t++)
+      { threads.emplace_back(fn, n*t/nthreads, n*(t+1)/nthreads); }
+    for(auto& th : threads) th.join();
+  }
+
+  class HistBDT
+  {
+  public:
+    HistBDT(std::string options, std::string methodname = "BDTG", unsigned int seed = 100);
+
+    bool isvalid() const { return fvalid; }
+    // "label := expression" as in DataLoader::AddVariable
+    void addvariable(std::string var, std::string title = "", std::string unit = "");
+    // events of t passing cut, weighted by treeweight * weightexpr; a fraction testfraction goes to the test sample
+    void addtree(TTree* t, double treeweight, bool signal, std::string weightexpr = "weight", std::string cut = "", double testfraction = 0.5);
+    // subsample of mytmva::StreamLoader, its buffers are released
+    void addsample(WeightedSample* s, bool signal, double testfraction = 0.5)
+    {
+      TTree* t = s->tree("sample");
+      addtree(t, 1., signal, "weight", "", testfraction);
+      delete t;
+    }
+    // nthreads 0: all cores
+    bool train(int nthreads = 0);
+    bool writexml(std::string filename) const;
+    // weighted ROC integral of the training or test sample
+    double rocintegral(bool test) const;
+
+  private:
+    struct Node
+    {
+      int var, cut; // right daughter: bin >= cut
+      float cutvalue;
+      int left, right;
+      int depth;
+      double response, purity;
+    };
+    struct Variable { std::string expression, label, title, unit; float min, max; };
+
+    bool fvalid;
+    std::string fmethodname;
+    unsigned int fseed;
+    std::vector<std::pair<std::string, std::string>> foptions;
+    int fntrees, fmaxdepth, fncuts;
+    double fminnodesize, fshrinkage, fbaggedfraction;
+    bool fbagged;
+    std::string fnegweight;
+    double ftraintime;
+
+    std::vector<Variable> fvars;
+    // events, training and test together
+    std::vector<std::vector<float>> fx; // [var][event], released after quantization
+    std::vector<std::vector<uint8_t>> fbin; // [var][event]
+    std::vector<uint8_t> fsignal, ftest;
+    std::vector<float> fweight;
+    std::vector<double> fscore;
+    std::vector<std::vector<float>> fedges; // [var]: cut values, bin k holds edges[k-1] <= x < edges[k]
+    std::vector<std::vector<Node>> fforest;
+    std::mt19937 frng;
+
+    void abort(std::string msg) { std::cout << "==> Abort mytmva::HistBDT: error: " << msg << std::endl; fvalid = false; }
+    void quantize(int nthreads);
+    int grow(std::vector<Node>& tree, std::vector<uint32_t>& idx, std::size_t begin, std::size_t end, int depth,
+             std::vector<double>& hist, const std::vector<double>& g, const std::vector<double>& h, const std::vector<float>& m,
+             double minsize, int nthreads);
+    void fillhist(std::vector<double>& hist, const std::vector<uint32_t>& idx, std::size_t begin, std::size_t end,
+                  const std::vector<double>& g, const std::vector<double>& h, const std::vector<float>& m, int nthreads) const;
+    std::size_t histoffset(int v) const { return (std::size_t)v*3*(fncuts+1); }
+    double treeresponse(const std::vector<Node>& tree, std::size_t i) const;
+    void writenode(TXMLEngine& xml, XMLNodePointer_t parent, const std::vector<Node>& tree, int inode, const char* pos) const;
+  };
+}
+
+inline mytmva::HistBDT::HistBDT(std::string options, std::string methodname, unsigned int seed)
+  : fvalid(true), fmethodname(methodname), fseed(seed), fntrees(800), fmaxdepth(3), fncuts(20),
+  fminnodesize(5), fshrinkage(1), fbaggedfraction(0.6), fbagged(false), fnegweight("Pray"), ftraintime(0), frng(seed)
+{
+  // TMVA syntax: Name=value, Name (true) or !Name (false), separated by ':'
+  std::size_t start = 0;
+  while(start <= options.size())
+    {
+      std::size_t stop = options.find(':', start);
+      if(stop == std::string::npos) stop = options.size();
+      std::string item = options.substr(start, stop-start);
+      start = stop+1;
+      if(item == "") continue;
+      std::size_t eq = item.find('=');
+      std::string name = eq == std::string::npos ? item : item.substr(0, eq);
+      std::string value = eq == std::string::npos ? "True" : item.substr(eq+1);
+      if(eq == std::string::npos && name[0] == '!') { name = name.substr(1); value = "False"; }
+      foptions.push_back(std::make_pair(name, value));
+
+      if(name == "NTrees") fntrees = std::atoi(value.c_str());
+      else if(name == "MaxDepth") fmaxdepth = std::atoi(value.c_str());
+      else if(name == "nCuts") fncuts = std::atoi(value.c_str());
+      else if(name == "MinNodeSize") fminnodesize = std::atof(value.c_str()); // percent, with or without '%'
+      else if(name == "Shrinkage") fshrinkage = std::atof(value.c_str());
+      else if(name == "UseBaggedBoost") fbagged = (value == "True");
+      else if(name == "BaggedSampleFraction") fbaggedfraction = std::atof(value.c_str());
+      else if(name == "NegWeightTreatment") fnegweight = value;
+      else if(name == "BoostType" && value != "Grad") abort("only BoostType=Grad is supported");
+    }
+  if(fnegweight == "InverseBoostNegWeights") fnegweight = "Pray";
+  if(fnegweight != "Pray" && fnegweight != "IgnoreNegWeightsInTraining") abort("unsupported NegWeightTreatment=" + fnegweight);
+  if(fncuts < 1 || fncuts > 255) abort("nCuts must be in 1-255");
+  if(fntrees < 1 || fmaxdepth < 1) abort("NTrees and MaxDepth must be positive");
+}
+
+inline void mytmva::HistBDT::addvariable(std::string var, std::string title, std::string unit)
+{
+  Variable v;
+  auto strip = [](std::string s) { s.erase(0, s.find_first_not_of(" ")); s.erase(s.find_last_not_of(" ")+1); return s; };
+  std::size_t def = var.find(":=");
+  v.label = strip(def == std::string::npos ? var : var.substr(0, def));
+  v.expression = strip(def == std::string::npos ? var : var.substr(def+2));
+  v.title = title == "" ? v.label : title;
+  v.unit = unit;
+  v.min = std::numeric_limits<float>::max();
+  v.max = -std::numeric_limits<float>::max();
+  fvars.push_back(v);
+  fx.resize(fvars.size());
+}
+
+inline void mytmva::HistBDT::addtree(TTree* t, double treeweight, bool signal, std::string weightexpr, std::string cut, double testfraction)
+{
+  if(!t) { abort("no input tree"); return; }
+  std::vector<TTreeFormula*> fv;
+  for(std::size_t v=0; v<fvars.size(); v++) { fv.push_back(new TTreeFormula(Form("histbdt%d", (int)v), fvars[v].expression.c_str(), t)); }
+  TTreeFormula* fw = new TTreeFormula("histbdtweight", weightexpr == "" ? "1" : weightexpr.c_str(), t);
+  TTreeFormula* fcut = new TTreeFormula("histbdtcut", cut == "" ? "1" : cut.c_str(), t);
+  std::uniform_real_distribution<double> uniform(0, 1);
+  Long64_t nentries = t->GetEntries(), nsel = 0;
+  for(Long64_t i=0; i<nentries; i++)
+    {
+      if(t->LoadTree(i) < 0) break;
+      fcut->GetNdata();
+      if(!fcut->EvalInstance(0)) continue;
+      for(std::size_t v=0; v<fvars.size(); v++) { fv[v]->GetNdata(); fx[v].push_back(fv[v]->EvalInstance(0)); }
+      fw->GetNdata();
+      fweight.push_back(treeweight * fw->EvalInstance(0));
+      fsignal.push_back(signal);
+      ftest.push_back(uniform(frng) < testfraction);
+      nsel++;
+    }
+  std::cout << "==> mytmva::HistBDT: " << (signal ? "signal" : "background") << " tree with " << nsel << " events, weight " << treeweight << std::endl;
+  for(auto& f : fv) delete f;
+  delete fw;
+  delete fcut;
+}
+
+inline void mytmva::HistBDT::quantize(int nthreads)
+{
+  std::size_t nevt = fweight.size();
+  int nv = fvars.size();
+  fedges.assign(nv, std::vector<float>());
+  fbin.assign(nv, std::vector<uint8_t>());
+  std::vector<std::thread> threads;
+  for(int t=0; t<nthreads; t++)
+    {
+      threads.emplace_back([&, t]()
+                           {
+                             for(int v=t; v<nv; v+=nthreads)
+                               {
+                                 std::vector<float> sorted;
+                                 for(std::size_t i=0; i<nevt; i++) { if(!ftest[i]) sorted.push_back(fx[v][i]); }
+                                 std::sort(sorted.begin(), sorted.end());
+                                 fvars[v].min = sorted.front();
+                                 fvars[v].max = sorted.back();
+                                 // cut values at the nCuts quantiles, without duplicates (discrete variables)
+                                 // and without the minimum, which would not separate anything
+                                 for(int k=1; k<=fncuts; k++)
+                                   {
+                                     float e = sorted[(std::size_t)((double)k/(fncuts+1)*sorted.size())];
+                                     if(e > sorted.front() && (fedges[v].empty() || e > fedges[v].back())) fedges[v].push_back(e);
+                                   }
+                                 fbin[v].resize(nevt);
+                                 for(std::size_t i=0; i<nevt; i++)
+                                   { fbin[v][i] = std::upper_bound(fedges[v].begin(), fedges[v].end(), fx[v][i]) - fedges[v].begin(); }
+                                 std::vector<float>().swap(fx[v]);
+                               }
+                           });
+    }
+  for(auto& th : threads) th.join();
+}
+
+inline void mytmva::HistBDT::fillhist(std::vector<double>& hist, const std::vector<uint32_t>& idx, std::size_t begin, std::size_t end,
+                               const std::vector<double>& g, const std::vector<double>& h, const std::vector<float>& m, int nthreads) const
+{
+  // per variable and bin: sum of w*r, sum of w, number of events (bagging multiplicity included)
+  int nv = fvars.size();
+  std::fill(hist.begin(), hist.end(), 0.);
+  std::vector<std::thread> threads;
+  auto fill = [&](int t)
+    {
+      for(int v=t; v<nv; v+=nthreads)
+        {
+          double* hv = &hist[histoffset(v)];
+          const uint8_t* bin = &fbin[v][0];
+          for(std::size_t j=begin; j<end; j++)
+            {
+              uint32_t i = idx[j];
+              double* hb = hv + 3*bin[i];
+              hb[0] += g[i];
+              hb[1] += h[i];
+              hb[2] += m[i];
+            }
+        }
+    };
+  if(nthreads <= 1 || end-begin < 1024) { nthreads = 1; fill(0); return; }
+  for(int t=0; t<nthreads; t++) { threads.emplace_back(fill, t); }
+  for(auto& th : threads) th.join();
+}
+
+inline int mytmva::HistBDT::grow(std::vector<Node>& tree, std::vector<uint32_t>& idx, std::size_t begin, std::size_t end, int depth,
+                          std::vector<double>& hist, const std::vector<double>& g, const std::vector<double>& h, const std::vector<float>& m,
+                          double minsize, int nthreads)
+{
+  int inode = tree.size();
+  tree.push_back(Node{-1, 0, 0.f, -1, -1, depth, 0., 0.});
+
+  // node sums from the histogram of the first variable
+  double gsum = 0, wsum = 0, nsum = 0;
+  for(std::size_t b=0; b<=fedges[0].size(); b++) { gsum += hist[3*b]; wsum += hist[3*b+1]; nsum += hist[3*b+2]; }
+
+  int bestvar = -1, bestcut = 0;
+  double bestgain = 0;
+  if(depth < fmaxdepth && nsum >= 2*minsize && wsum > 0)
+    {
+      double parent = gsum*gsum/wsum;
+      for(std::size_t v=0; v<fvars.size(); v++)
+        {
+          const double* hv = &hist[histoffset(v)];
+          double gl = 0, wl = 0, nl = 0;
+          for(std::size_t k=1; k<=fedges[v].size(); k++)
+            {
+              gl += hv[3*(k-1)]; wl += hv[3*(k-1)+1]; nl += hv[3*(k-1)+2];
+              double gr = gsum-gl, wr = wsum-wl, nr = nsum-nl;
+              if(nl < minsize || nr < minsize || wl <= 0 || wr <= 0) continue;
+              double gain = gl*gl/wl + gr*gr/wr - parent;
+              if(gain > bestgain) { bestgain = gain; bestvar = v; bestcut = k; }
+            }
+        }
+    }
+
+  if(bestvar < 0)
+    {
+      // leaf: Newton step of the binomial log-likelihood (MethodBDT::GradBoost)
+      double num = 0, den = 0, sig = 0, all = 0;
+      for(std::size_t j=begin; j<end; j++)
+        {
+          uint32_t i = idx[j];
+          double r = std::fabs(g[i]/(h[i] ? h[i] : 1));
+          num += g[i];
+          den += h[i]*r*(1-r);
+          all += h[i];
+          if(fsignal[i]) sig += h[i];
+        }
+      tree[inode].response = fshrinkage/2 * num/std::max(den, 1.e-30);
+      tree[inode].purity = all ? sig/all : 0;
+      return inode;
+    }
+
+  double sig = 0;
+  for(std::size_t j=begin; j<end; j++) { if(fsignal[idx[j]]) sig += h[idx[j]]; }
+  tree[inode].var = bestvar;
+  tree[inode].cut = bestcut;
+  tree[inode].cutvalue = fedges[bestvar][bestcut-1];
+  tree[inode].response = wsum ? gsum/wsum : 0;
+  tree[inode].purity = wsum ? sig/wsum : 0;
+
+  const uint8_t* bin = &fbin[bestvar][0];
+  std::size_t mid = std::partition(idx.begin()+begin, idx.begin()+end, [&](uint32_t i) { return bin[i] < bestcut; }) - idx.begin();
+
+  // histograms of the smaller daughter are filled, the other one's are the difference
+  std::vector<double> small(hist.size()), large(hist.size());
+  bool leftsmall = mid-begin <= end-mid;
+  if(leftsmall) fillhist(small, idx, begin, mid, g, h, m, nthreads);
+  else fillhist(small, idx, mid, end, g, h, m, nthreads);
+  for(std::size_t k=0; k<hist.size(); k++) { large[k] = hist[k] - small[k]; }
+  int left = grow(tree, idx, begin, mid, depth+1, leftsmall ? small : large, g, h, m, minsize, nthreads);
+  int right = grow(tree, idx, mid, end, depth+1, leftsmall ? large : small, g, h, m, minsize, nthreads);
+  tree[inode].left = left;
+  tree[inode].right = right;
+  return inode;
+}
+
+inline double mytmva::HistBDT::treeresponse(const std::vector<Node>& tree, std::size_t i) const
+{
+  int n = 0;
+  while(tree[n].var >= 0) { n = fbin[tree[n].var][i] >= tree[n].cut ? tree[n].right : tree[n].left; }
+  return tree[n].response;
+}
+
+inline bool mytmva::HistBDT::train(int nthreads)
+{
+  if(!fvalid) return false;
+  if(nthreads <= 0) nthreads = std::max(1u, std::thread::hardware_concurrency());
+  std::size_t nevt = fweight.size();
+  if(fvars.empty() || nevt == 0) { abort("no variables or no events"); return false; }
+  auto start = std::chrono::steady_clock::now();
+
+  // NormMode=NumEvents on the training sample, the test sample is scaled alike
+  double sumw[2] = {0, 0}, n[2] = {0, 0};
+  for(std::size_t i=0; i<nevt; i++)
+    {
+      if(ftest[i]) continue;
+      if(fnegweight == "IgnoreNegWeightsInTraining" && fweight[i] < 0) continue;
+      sumw[fsignal[i]] += fweight[i];
+      n[fsignal[i]]++;
+    }
+  if(sumw[0] <= 0 || sumw[1] <= 0) { abort("no signal or background training events"); return false; }
+  for(std::size_t i=0; i<nevt; i++) { fweight[i] *= n[fsignal[i]]/sumw[fsignal[i]]; }
+  std::cout << "==> mytmva::HistBDT: training " << fmethodname << " on " << n[1] << " signal, " << n[0] << " background events, "
+            << fvars.size() << " variables, " << nthreads << " threads" << std::endl;
+
+  quantize(nthreads);
+
+  std::size_t nbin = fncuts+1;
+  std::vector<double> g(nevt), h(nevt);
+  std::vector<float> m(nevt);
+  std::vector<uint32_t> idx;
+  idx.reserve(nevt);
+  std::vector<double> hist(fvars.size()*3*nbin);
+  fscore.assign(nevt, 0.);
+  fforest.clear();
+  const std::size_t chunk = 1 << 16;
+  for(int itree=0; itree<fntrees; itree++)
+    {
+      // residuals and bagging multiplicities (Poisson, as MethodBDT::GetBaggedSubSample); the random
+      // numbers are drawn per fixed-size chunk so the result does not depend on the number of threads
+      std::size_t nchunk = (nevt + chunk-1)/chunk;
+      parallelrange(nchunk, nthreads, [&](std::size_t cb, std::size_t ce)
+                    {
+                      for(std::size_t c=cb; c<ce; c++)
+                        {
+                          std::mt19937 rng(fseed + 1000003u*(itree+1) + 7919u*c);
+                          std::poisson_distribution<int> poisson(fbaggedfraction);
+                          for(std::size_t i=c*chunk; i<std::min(nevt, (c+1)*chunk); i++)
+                            {
+                              bool use = !ftest[i] && !(fnegweight == "IgnoreNegWeightsInTraining" && fweight[i] < 0);
+                              m[i] = !use ? 0 : fbagged ? poisson(rng) : 1;
+                              double r = fsignal[i] - 1./(1.+std::exp(-2.*fscore[i]));
+                              h[i] = m[i]*fweight[i];
+                              g[i] = h[i]*r;
+                            }
+                        }
+                    });
+      idx.clear();
+      double nbag = 0;
+      for(std::size_t i=0; i<nevt; i++) { if(m[i] > 0) { idx.push_back(i); nbag += m[i]; } }
+
+      fillhist(hist, idx, 0, idx.size(), g, h, m, nthreads);
+      std::vector<Node> tree;
+      grow(tree, idx, 0, idx.size(), 0, hist, g, h, m, fminnodesize/100.*nbag, nthreads);
+      parallelrange(nevt, nthreads, [&](std::size_t b, std::size_t e)
+                    { for(std::size_t i=b; i<e; i++) { fscore[i] += treeresponse(tree, i); } });
+      fforest.push_back(tree);
+
+      if((itree+1) % std::max(1, fntrees/10) == 0)
+        { std::cout << "==> mytmva::HistBDT: " << itree+1 << "/" << fntrees << " trees" << std::endl; }
+    }
+  ftraintime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::cout << "==> mytmva::HistBDT: trained " << fmethodname << " in " << ftraintime << " s, ROC integral training "
+            << rocintegral(false) << ", test " << rocintegral(true) << std::endl;
+  return true;
+}
+
+inline double mytmva::HistBDT::rocintegral(bool test) const
+{
+  std::vector<uint32_t> order;
+  double total[2] = {0, 0};
+  for(std::size_t i=0; i<fscore.size(); i++)
+    {
+      if((bool)ftest[i] != test) continue;
+      order.push_back(i);
+      total[fsignal[i]] += fweight[i];
+    }
+  if(total[0] == 0 || total[1] == 0) return 0;
+  std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return fscore[a] < fscore[b]; });
+  // area under background rejection vs signal efficiency, ties count half
+  double integral = 0, bkgbelow = 0;
+  for(std::size_t j=0; j<order.size(); )
+    {
+      std::size_t k = j;
+      double s = 0, b = 0;
+      for(; k<order.size() && fscore[order[k]] == fscore[order[j]]; k++)
+        { if(fsignal[order[k]]) s += fweight[order[k]]; else b += fweight[order[k]]; }
+      integral += s*(bkgbelow + 0.5*b);
+      bkgbelow += b;
+      j = k;
+    }
+  return integral/(total[0]*total[1]);
+}
+
+inline void mytmva::HistBDT::writenode(TXMLEngine& xml, XMLNodePointer_t parent, const std::vector<Node>& tree, int inode, const char* pos) const
+{
+  // attributes as DecisionTreeNode::AddAttributesToNode
+  const Node& n = tree[inode];
+  bool leaf = n.var < 0;
+  XMLNodePointer_t node = xml.NewChild(parent, 0, "Node");
+  xml.NewAttr(node, 0, "pos", pos);
+  xml.NewIntAttr(node, "depth", n.depth);
+  xml.NewIntAttr(node, "NCoef", 0);
+  xml.NewIntAttr(node, "IVar", leaf ? -1 : n.var);
+  xml.NewAttr(node, 0, "Cut", Form("%.9e", leaf ? 0. : (double)n.cutvalue));
+  xml.NewIntAttr(node, "cType", 1);
+  xml.NewAttr(node, 0, "res", Form("%.16e", n.response));
+  xml.NewAttr(node, 0, "rms", "0.0000000000000000e+00");
+  xml.NewAttr(node, 0, "purity", Form("%.16e", n.purity));
+  xml.NewIntAttr(node, "nType", leaf ? (n.purity > 0.5 ? 1 : -1) : 0);
+  if(leaf) return;
+  writenode(xml, node, tree, n.left, "l");
+  writenode(xml, node, tree, n.right, "r");
+}
+
+inline bool mytmva::HistBDT::writexml(std::string filename) const
+{
+  if(!fvalid || fforest.empty()) { std::cout << "==> Abort mytmva::HistBDT: error: nothing trained." << std::endl; return false; }
+  TXMLEngine xml;
+  XMLDocPointer_t doc = xml.NewDoc();
+  XMLNodePointer_t setup = xml.NewChild(0, 0, "MethodSetup");
+  xml.NewAttr(setup, 0, "Method", ("BDT::" + fmethodname).c_str());
+  xml.DocSetRootElement(doc, setup);
+
+  // the reader takes the TMVA version code in [] to choose the node format
+  XMLNodePointer_t info = xml.NewChild(setup, 0, "GeneralInfo");
+  time_t now = std::time(0);
+  std::string date = std::ctime(&now);
+  date.erase(date.find_last_not_of("\n")+1);
+  std::vector<std::pair<std::string, std::string>> infos = {
+    {"TMVA Release", Form("%s [%d]", TMVA_RELEASE, TMVA_VERSION_CODE)},
+    {"ROOT Release", Form("%s [%d]", gROOT->GetVersion(), gROOT->GetVersionCode())},
+    {"Creator", gSystem->Getenv("USER") ? gSystem->Getenv("USER") : ""},
+    {"Date", date},
+    {"Host", gSystem->HostName()},
+    {"Dir", gSystem->WorkingDirectory()},
+    {"Training events", Form("%d", (int)std::count(ftest.begin(), ftest.end(), 0))},
+    {"TrainingTime", Form("%.16e", ftraintime)},
+    {"AnalysisType", "Classification"}};
+  for(auto& i : infos)
+    {
+      XMLNodePointer_t n = xml.NewChild(info, 0, "Info");
+      xml.NewAttr(n, 0, "name", i.first.c_str());
+      xml.NewAttr(n, 0, "value", i.second.c_str());
+    }
+
+  XMLNodePointer_t options = xml.NewChild(setup, 0, "Options");
+  for(auto& o : foptions)
+    {
+      XMLNodePointer_t n = xml.NewChild(options, 0, "Option", o.second.c_str());
+      xml.NewAttr(n, 0, "name", o.first.c_str());
+      xml.NewAttr(n, 0, "modified", "Yes");
+    }
+
+  XMLNodePointer_t variables = xml.NewChild(setup, 0, "Variables");
+  xml.NewIntAttr(variables, "NVar", fvars.size());
+  for(std::size_t v=0; v<fvars.size(); v++)
+    {
+      TString internal(fvars[v].label.c_str());
+      internal.ReplaceAll(" ", ""); internal.ReplaceAll("/", "_D_"); internal.ReplaceAll("*", "_T_");
+      internal.ReplaceAll("+", "_P_"); internal.ReplaceAll("-", "_M_");
+      for(const char* c : {"(", ")", "[", "]", ":", ",", "<", ">", "=", "!", "&", "|"}) internal.ReplaceAll(c, "_");
+      XMLNodePointer_t n = xml.NewChild(variables, 0, "Variable");
+      xml.NewIntAttr(n, "VarIndex", v);
+      xml.NewAttr(n, 0, "Expression", fvars[v].expression.c_str());
+      xml.NewAttr(n, 0, "Label", fvars[v].label.c_str());
+      xml.NewAttr(n, 0, "Title", fvars[v].title.c_str());
+      xml.NewAttr(n, 0, "Unit", fvars[v].unit.c_str());
+      xml.NewAttr(n, 0, "Internal", internal.Data());
+      xml.NewAttr(n, 0, "Type", "F");
+      xml.NewAttr(n, 0, "Min", Form("%.16e", (double)fvars[v].min));
+      xml.NewAttr(n, 0, "Max", Form("%.16e", (double)fvars[v].max));
+    }
+  xml.NewIntAttr(xml.NewChild(setup, 0, "Spectators"), "NSpec", 0);
+  XMLNodePointer_t classes = xml.NewChild(setup, 0, "Classes");
+  xml.NewIntAttr(classes, "NClass", 2);
+  const char* classnames[2] = {"Signal", "Background"};
+  for(int c=0; c<2; c++)
+    {
+      XMLNodePointer_t n = xml.NewChild(classes, 0, "Class");
+      xml.NewAttr(n, 0, "Name", classnames[c]);
+      xml.NewIntAttr(n, "Index", c);
+    }
+  xml.NewIntAttr(xml.NewChild(setup, 0, "Transformations"), "NTransformations", 0);
+  xml.NewChild(setup, 0, "MVAPdfs");
+
+  // gradient boosted trees are regression trees (AnalysisType 1) with unit boost weights
+  XMLNodePointer_t weights = xml.NewChild(setup, 0, "Weights");
+  xml.NewIntAttr(weights, "NTrees", fforest.size());
+  xml.NewIntAttr(weights, "AnalysisType", 1);
+  for(std::size_t t=0; t<fforest.size(); t++)
+    {
+      XMLNodePointer_t tree = xml.NewChild(weights, 0, "BinaryTree");
+      xml.NewAttr(tree, 0, "type", "DecisionTree");
+      xml.NewAttr(tree, 0, "boostWeight", "1.0000000000000000e+00");
+      xml.NewIntAttr(tree, "itree", t);
+      writenode(xml, tree, fforest[t], 0, "s");
+    }
+
+  gSystem->mkdir(gSystem->DirName(filename.c_str()), true);
+  xml.SaveDoc(doc, filename.c_str());
+  xml.FreeDoc(doc);
+  std::cout << "==> mytmva::HistBDT: wrote " << filename << std::endl;
+  return true;
+}
+
+#endif
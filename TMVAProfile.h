@@ -0,0 +1,294 @@
+#ifndef _TMVAPROFILE_H_
+#define _TMVAPROFILE_H_
+
+// Per-phase profile of a job: wall time, CPU time, bytes read, events per second and peak RSS of each
+// phase (open, read, evaluate, write, ...), optionally per method. It is written to the output file as the
+// tree "tmvaprofile" (one entry per phase) and to a JSON summary.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+
+#include "TDirectory.h"
+#include "TFile.h"
+#include "TSystem.h"
+#include "TTree.h"
+
+namespace mytmva
+{
+  // CPU time in s of the calling thread (thread = true) or of the whole process
+  double cputime(bool thread);
+  // high-water mark of the resident set size of the process in kB
+  Long64_t peakrss();
+
+  struct Phase
+  {
+    std::string phase, method;
+    Long64_t calls;
+    double wall, cpu; // s, cpu < 0: not measured
+    Long64_t bytes, events;
+    Long64_t peakrss; // kB, at the end of the phase
+  };
+
+  class Profiler
+  {
+  public:
+    // perthread: phases run concurrently and are charged the CPU time of their own thread only,
+    // otherwise the CPU time of the process
+    Profiler(std::string job, bool perthread = false) : fjob(job), fperthread(perthread) { ; }
+
+    // times a phase from construction to destruction or stop(). Bytes read are those of file, or of all
+    // files of the process (TFile::GetFileBytesRead) without one
+    class Scope
+    {
+    public:
+      Scope(Profiler& p, std::string phase, std::string method = "", TFile* file = 0);
+      ~Scope() { stop(); }
+      void stop();
+      void setevents(Long64_t n) { fevents = n; }
+      // count the bytes read from a file opened during the phase
+      void setfile(TFile* file) { ffile = file; fbytes = 0; }
+
+    private:
+      Profiler& fp;
+      std::string fphase, fmethod;
+      TFile* ffile;
+      bool fstopped;
+      std::chrono::steady_clock::time_point fstart;
+      double fcpu;
+      Long64_t fbytes, fevents;
+    };
+
+    // sums many short intervals of one phase, e.g. a step of the event loop. Only the wall time and
+    // the bytes read of all files are taken, reading the CPU clock would cost a system call per event
+    class Laps
+    {
+    public:
+      Laps() : fwall(0), fbytes(0), fcalls(0) { ; }
+      void start() { fstart = std::chrono::steady_clock::now(); fbytes0 = TFile::GetFileBytesRead(); }
+      void stop()
+      {
+        fwall += std::chrono::duration<double>(std::chrono::steady_clock::now() - fstart).count();
+        fbytes += TFile::GetFileBytesRead() - fbytes0;
+        fcalls++;
+      }
+      double wall() const { return fwall; }
+      Long64_t bytes() const { return fbytes; }
+      Long64_t calls() const { return fcalls; }
+
+    private:
+      std::chrono::steady_clock::time_point fstart;
+      double fwall;
+      Long64_t fbytes0, fbytes, fcalls;
+    };
+
+    bool perthread() const { return fperthread; }
+    // phases of the same name and method are summed
+    void add(std::string phase, std::string method, double wall, double cpu, Long64_t bytes, Long64_t events, Long64_t calls = 1);
+    void add(std::string phase, std::string method, const Laps& laps, Long64_t events)
+    { add(phase, method, laps.wall(), -1, laps.bytes(), events, laps.calls()); }
+    void add(const Phase& p);
+    void merge(const Profiler& other);
+    std::vector<Phase> phases() const;
+
+    void print() const;
+    // tree name with one entry per phase in dir, owned by dir
+    void write(TDirectory* dir, std::string name = "tmvaprofile") const;
+    bool writejson(std::string filename) const;
+    // phases of a summary written by writejson
+    static std::vector<Phase> readjson(std::string filename);
+
+  private:
+    std::string fjob;
+    bool fperthread;
+    std::vector<Phase> fphases;
+    std::map<std::pair<std::string, std::string>, std::size_t> findex;
+    mutable std::mutex fmutex;
+  };
+}
+
+inline double mytmva::cputime(bool thread)
+{
+  timespec ts;
+  if(clock_gettime(thread ? CLOCK_THREAD_CPUTIME_ID : CLOCK_PROCESS_CPUTIME_ID, &ts)) return 0;
+  return ts.tv_sec + 1.e-9*ts.tv_nsec;
+}
+
+inline Long64_t mytmva::peakrss()
+{
+  rusage ru;
+  if(getrusage(RUSAGE_SELF, &ru)) return 0;
+  return ru.ru_maxrss;
+}
+
+inline mytmva::Profiler::Scope::Scope(Profiler& p, std::string phase, std::string method, TFile* file) :
+  fp(p), fphase(phase), fmethod(method), ffile(file), fstopped(false), fevents(0)
+{
+  fbytes = ffile ? ffile->GetBytesRead() : TFile::GetFileBytesRead();
+  fcpu = cputime(fp.perthread());
+  fstart = std::chrono::steady_clock::now();
+}
+
+inline void mytmva::Profiler::Scope::stop()
+{
+  if(fstopped) return;
+  fstopped = true;
+  double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - fstart).count();
+  double cpu = cputime(fp.perthread()) - fcpu;
+  Long64_t bytes = (ffile ? ffile->GetBytesRead() : TFile::GetFileBytesRead()) - fbytes;
+  fp.add(fphase, fmethod, wall, cpu, bytes, fevents);
+}
+
+inline void mytmva::Profiler::add(std::string phase, std::string method, double wall, double cpu, Long64_t bytes, Long64_t events, Long64_t calls)
+{
+  add(Phase{phase, method, calls, wall, cpu, bytes, events, peakrss()});
+}
+
+inline void mytmva::Profiler::add(const Phase& p)
+{
+  std::lock_guard<std::mutex> lock(fmutex);
+  auto key = std::make_pair(p.phase, p.method);
+  auto it = findex.find(key);
+  if(it == findex.end())
+    {
+      findex[key] = fphases.size();
+      fphases.push_back(p);
+      return;
+    }
+  Phase& q = fphases[it->second];
+  q.calls += p.calls;
+  q.wall += p.wall;
+  q.cpu = (q.cpu < 0 || p.cpu < 0) ? -1 : q.cpu + p.cpu;
+  q.bytes += p.bytes;
+  q.events += p.events;
+  q.peakrss = std::max(q.peakrss, p.peakrss);
+}
+
+inline void mytmva::Profiler::merge(const Profiler& other)
+{
+  for(auto& p : other.phases()) { add(p); }
+}
+
+inline std::vector<mytmva::Phase> mytmva::Profiler::phases() const
+{
+  std::lock_guard<std::mutex> lock(fmutex);
+  return fphases;
+}
+
+inline void mytmva::Profiler::print() const
+{
+  std::cout << "==> Profile of " << fjob << (fperthread ? " (CPU and wall time summed over threads)" : "") << std::endl;
+  char line[256];
+  snprintf(line, sizeof(line), "  %-16s %-10s %8s %10s %10s %12s %12s %12s %10s", "phase", "method", "calls", "wall[s]", "cpu[s]", "read[MB]", "events", "evt/s", "rss[MB]");
+  std::cout << line << std::endl;
+  char cpu[32];
+  for(auto& p : phases())
+    {
+      if(p.cpu < 0) snprintf(cpu, sizeof(cpu), "-");
+      else snprintf(cpu, sizeof(cpu), "%.3f", p.cpu);
+      snprintf(line, sizeof(line), "  %-16s %-10s %8lld %10.3f %10s %12.2f %12lld %12.4g %10.1f", p.phase.c_str(), p.method.c_str(), p.calls, p.wall,
+               cpu, p.bytes/1048576., p.events, p.wall > 0 ? p.events/p.wall : 0., p.peakrss/1024.);
+      std::cout << line << std::endl;
+    }
+}
+
+inline void mytmva::Profiler::write(TDirectory* dir, std::string name) const
+{
+  TDirectory* save = gDirectory;
+  dir->cd();
+  Phase p;
+  double evtpers;
+  TTree* t = new TTree(name.c_str(), ("profile of " + fjob).c_str());
+  t->Branch("phase", &p.phase);
+  t->Branch("method", &p.method);
+  t->Branch("calls", &p.calls);
+  t->Branch("wall", &p.wall);
+  t->Branch("cpu", &p.cpu);
+  t->Branch("bytes", &p.bytes);
+  t->Branch("events", &p.events);
+  t->Branch("evtpers", &evtpers);
+  t->Branch("peakrss", &p.peakrss);
+  for(auto& q : phases())
+    {
+      p = q;
+      evtpers = p.wall > 0 ? p.events/p.wall : 0;
+      t->Fill();
+    }
+  t->Write();
+  t->ResetBranchAddresses();
+  save->cd();
+}
+
+inline bool mytmva::Profiler::writejson(std::string filename) const
+{
+  std::ofstream out(filename);
+  if(!out) { std::cout << "==> Abort " << __FUNCTION__ << ": error: cannot write " << filename << "." << std::endl; return false; }
+  auto quote = [](const std::string& s)
+    {
+      std::string q = "\"";
+      for(char c : s) { if(c == '"' || c == '\\') q += '\\'; q += c; }
+      return q + "\"";
+    };
+  out << "{" << std::endl;
+  out << "  \"job\": " << quote(fjob) << "," << std::endl;
+  out << "  \"host\": " << quote(gSystem->HostName()) << "," << std::endl;
+  out << "  \"perthread\": " << (fperthread ? "true" : "false") << "," << std::endl;
+  out << "  \"phases\": [" << std::endl;
+  std::vector<Phase> ph = phases();
+  char num[64];
+  for(std::size_t i=0; i<ph.size(); i++)
+    {
+      const Phase& p = ph[i];
+      // one phase per line, so the summaries can also be compared with grep
+      out << "    {\"phase\": " << quote(p.phase) << ", \"method\": " << quote(p.method) << ", \"calls\": " << p.calls;
+      snprintf(num, sizeof(num), "%.6f", p.wall);
+      out << ", \"wall_s\": " << num;
+      snprintf(num, sizeof(num), "%.6f", p.cpu);
+      out << ", \"cpu_s\": " << (p.cpu < 0 ? "null" : num);
+      out << ", \"bytes_read\": " << p.bytes << ", \"events\": " << p.events;
+      snprintf(num, sizeof(num), "%.6g", p.wall > 0 ? p.events/p.wall : 0.);
+      out << ", \"events_per_s\": " << num << ", \"peak_rss_kb\": " << p.peakrss << "}" << (i+1 < ph.size() ? "," : "") << std::endl;
+    }
+  out << "  ]" << std::endl;
+  out << "}" << std::endl;
+  return true;
+}
+
+inline std::vector<mytmva::Phase> mytmva::Profiler::readjson(std::string filename)
+{
+  std::vector<Phase> ph;
+  std::ifstream in(filename);
+  if(!in) { std::cout << "==> Abort " << __FUNCTION__ << ": error: cannot read " << filename << "." << std::endl; return ph; }
+  // the value of key in a line of writejson, strings unquoted
+  auto value = [](const std::string& line, const std::string& key)
+    {
+      std::size_t pos = line.find("\"" + key + "\": ");
+      if(pos == std::string::npos) return std::string("");
+      pos += key.size() + 4;
+      if(line[pos] != '"') return line.substr(pos, line.find_first_of(",}", pos) - pos);
+      std::string s;
+      for(pos++; pos < line.size() && line[pos] != '"'; pos++) { if(line[pos] == '\\') pos++; s += line[pos]; }
+      return s;
+    };
+  std::string line;
+  while(std::getline(in, line))
+    {
+      if(line.find("\"phase\": ") == std::string::npos) continue;
+      std::string cpu = value(line, "cpu_s");
+      ph.push_back(Phase{value(line, "phase"), value(line, "method"), std::atoll(value(line, "calls").c_str()), std::atof(value(line, "wall_s").c_str()),
+            cpu == "null" ? -1 : std::atof(cpu.c_str()), std::atoll(value(line, "bytes_read").c_str()), std::atoll(value(line, "events").c_str()),
+            std::atoll(value(line, "peak_rss_kb").c_str())});
+    }
+  return ph;
+}
+
+#endif
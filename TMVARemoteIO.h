@@ -0,0 +1,675 @@
+#ifndef _TMVAREMOTEIO_H_
+#define _TMVAREMOTEIO_H_
+
+// Reading remote (xrootd) inputs through a local block cache with asynchronous read-ahead, and uploading
+// outputs in the background.
+//
+// - remoteio     : settings, from the environment by default
+//                    TMVA_CACHEDIR     directory of the block cache; unset: files are opened directly
+//                    TMVA_CACHEMB      size limit of the cache in MB (20000)
+//                    TMVA_READAHEADMB  how far the read-ahead may run ahead of the reader in MB (256)
+//                    TMVA_CACHELOCAL   1: local files go through the cache as well, to test without a server
+// - openinput    : TFile::Open, or a CachedFile for remote files when the cache is set
+// - BlockCache   : fixed-size blocks of remote files in <dir>/<key>/<block>, shared by the threads and the
+//                  processes using the same directory. The least recently used blocks are removed when the
+//                  size limit is exceeded; <dir>/<key>/header, the start of the file, is never removed
+// - CachedFile   : a read-only TFile whose reads are served from the BlockCache, and missing blocks fetched
+//                  from the remote file (opened raw). prefetch() queues byte ranges to be fetched by a
+//                  background thread, in order and at most the read-ahead size ahead of the reader. The
+//                  background thread has its own connection and fetches up to 16 blocks with one vector
+//                  read, so the reader's own fetches never wait for it
+// - basketranges : the byte ranges of the baskets of some branches that hold an entry range, to prefetch
+//                  the next clusters while the current one is processed
+// - Uploader     : copies finished output files (TFile::Cp, root:// or local) in a background thread
+//
+// A file is identified in the cache by its URL, size and modification time, and its cached blocks are dropped
+// when the header (which holds the UUID) differs from the one stored with them. The blocks fetched by a CachedFile are also counted as read by the raw
+// remote file, so TFile::GetFileBytesRead includes both the local and the remote reads.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <utime.h>
+#include <sys/stat.h>
+
+#include "TBranch.h"
+#include "TFile.h"
+#include "TMD5.h"
+#include "TObjArray.h"
+#include "TROOT.h"
+#include "TString.h"
+#include "TSystem.h"
+#include "TTree.h"
+
+namespace mytmva
+{
+  struct RemoteIOConfig
+  {
+    std::string cachedir;
+    Long64_t cachemb, readaheadmb;
+    bool cachelocal;
+  };
+  RemoteIOConfig& remoteio();
+  bool isremote(const std::string& name);
+  TFile* openinput(std::string name);
+
+  class BlockCache
+  {
+  public:
+    BlockCache(std::string dir, Long64_t maxbytes, Int_t blocksize = 1024*1024);
+    Int_t blocksize() const { return fblocksize; }
+    // whole block into buf (len bytes), false when it is not cached
+    bool read(const std::string& key, Long64_t iblock, char* buf, Int_t len);
+    bool has(const std::string& key, Long64_t iblock, Int_t len) const;
+    void write(const std::string& key, Long64_t iblock, const char* buf, Int_t len);
+    void invalidate(const std::string& key);
+    // drops the blocks of key when they were cached with another header, and keeps header for the next check;
+    // false when they were dropped
+    bool checkheader(const std::string& key, const std::vector<char>& header);
+
+  private:
+    std::string fdir;
+    Long64_t fmaxbytes;
+    Int_t fblocksize;
+    std::atomic<Long64_t> fbytes;
+    std::mutex fshrinkmutex;
+
+    std::string path(const std::string& key, Long64_t iblock) const { return fdir + "/" + key + "/" + std::to_string(iblock); }
+    std::string headerpath(const std::string& key) const { return fdir + "/" + key + "/header"; }
+    // file written under a temporary name and renamed, so readers see either no file or a complete one
+    bool writefile(const std::string& p, const char* buf, Int_t len) const;
+    Long64_t scan(std::vector<std::pair<time_t, std::pair<Long64_t, std::string>>>* files) const;
+    void shrink();
+  };
+
+  class CachedFile : public TFile
+  {
+  public:
+    CachedFile(std::string url, BlockCache* cache, Long64_t readahead);
+    virtual ~CachedFile();
+    // byte ranges [first, last) to fetch in the background, in place of those queued before
+    void prefetch(const std::vector<std::pair<Long64_t, Long64_t>>& ranges);
+    Long64_t nhit() const { return fnhit; }
+    Long64_t nfetch() const { return fnfetch; }
+    Long64_t fetchbytes() const { return ffetchbytes; }
+    double fetchtime() const { return ffetchtime; }
+
+  protected:
+    virtual Int_t SysOpen(const char* pathname, Int_t flags, UInt_t mode);
+    virtual Int_t SysClose(Int_t fd);
+    virtual Int_t SysRead(Int_t fd, void* buf, Int_t len);
+    virtual Int_t SysWrite(Int_t fd, const void* buf, Int_t len);
+    virtual Long64_t SysSeek(Int_t fd, Long64_t offset, Int_t whence);
+    virtual Int_t SysStat(Int_t fd, Long_t* id, Long64_t* size, Long_t* flags, Long_t* modtime);
+    virtual Int_t SysSync(Int_t fd);
+
+  private:
+    // reads of the reader thread, and of the read-ahead thread, which opens its own
+    TFile* fbackend;
+    TFile* fprefetchbackend;
+    BlockCache* fcache;
+    std::string fkey;
+    Long64_t fsize, foffset;
+    Int_t fblocksize;
+    Long64_t fahead; // blocks
+
+    // block being read
+    Long64_t fcurrent;
+    std::vector<char> fbuffer;
+
+    std::mutex fmutex;
+    std::condition_variable fcv;
+    std::deque<Long64_t> fqueue;
+    std::set<Long64_t> finflight;
+    Long64_t fdemand;
+    bool fstop;
+    std::thread fthread;
+
+    std::atomic<Long64_t> fnhit, fnfetch, ffetchbytes;
+    std::atomic<double> ffetchtime;
+
+    Int_t blocklen(Long64_t iblock) const { return std::min((Long64_t)fblocksize, fsize - iblock*fblocksize); }
+    bool fetch(Long64_t iblock, char* buf);
+    // blocks in one vector read of fprefetchbackend, into buf (blocksize bytes per block)
+    bool fetch(const std::vector<Long64_t>& blocks, char* buf);
+    void addfetch(Long64_t nblocks, Long64_t bytes, std::chrono::steady_clock::time_point start);
+    bool load(Long64_t iblock);
+    void loop();
+  };
+
+  std::vector<TBranch*> activebranches(TTree* t);
+  std::vector<std::pair<Long64_t, Long64_t>> basketranges(const std::vector<TBranch*>& branches, Long64_t first, Long64_t last);
+
+  class Uploader
+  {
+  public:
+    // files are copied to dest/<file name>; removelocal: delete the local file after a successful copy
+    Uploader(std::string dest, bool removelocal = true);
+    ~Uploader() { wait(); }
+    void add(std::string localfile);
+    // block until every queued file is copied, returns the number of failed copies
+    int wait();
+
+  private:
+    std::string fdest;
+    bool fremovelocal;
+    std::deque<std::string> fqueue;
+    int fpending, fnfail;
+    bool fstop;
+    std::mutex fmutex;
+    std::condition_variable fcv;
+    std::thread fthread;
+
+    void loop();
+  };
+}
+
+inline mytmva::RemoteIOConfig& mytmva::remoteio()
+{
+  static RemoteIOConfig config = []
+    {
+      RemoteIOConfig c;
+      const char* dir = std::getenv("TMVA_CACHEDIR");
+      const char* mb = std::getenv("TMVA_CACHEMB");
+      const char* ahead = std::getenv("TMVA_READAHEADMB");
+      const char* local = std::getenv("TMVA_CACHELOCAL");
+      c.cachedir = dir ? dir : "";
+      c.cachemb = mb ? std::atoll(mb) : 20000;
+      c.readaheadmb = ahead ? std::atoll(ahead) : 256;
+      c.cachelocal = local && std::string(local) == "1";
+      return c;
+    }();
+  return config;
+}
+
+inline bool mytmva::isremote(const std::string& name)
+{
+  return name.find("://") != std::string::npos && name.compare(0, 7, "file://") != 0;
+}
+
+inline TFile* mytmva::openinput(std::string name)
+{
+  const RemoteIOConfig& c = remoteio();
+  if(c.cachedir == "" || (!isremote(name) && !c.cachelocal)) return TFile::Open(name.c_str());
+  static std::mutex mutex;
+  static std::unique_ptr<BlockCache> cache;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if(!cache) cache.reset(new BlockCache(c.cachedir, c.cachemb*1024*1024));
+  }
+  CachedFile* f = new CachedFile(name, cache.get(), c.readaheadmb*1024*1024);
+  if(!f->IsZombie()) return f;
+  std::cout << "==> " << __FUNCTION__ << ": warning: cannot read " << name << " through the cache, opening it directly." << std::endl;
+  delete f;
+  return TFile::Open(name.c_str());
+}
+
+//
+
+inline mytmva::BlockCache::BlockCache(std::string dir, Long64_t maxbytes, Int_t blocksize) : fdir(dir), fmaxbytes(maxbytes), fblocksize(blocksize)
+{
+  gSystem->mkdir(fdir.c_str(), true);
+  fbytes = scan(0);
+}
+
+// size of all blocks in the cache, and the blocks with their last use
+inline Long64_t mytmva::BlockCache::scan(std::vector<std::pair<time_t, std::pair<Long64_t, std::string>>>* files) const
+{
+  Long64_t total = 0;
+  DIR* top = opendir(fdir.c_str());
+  if(!top) return 0;
+  while(dirent* k = readdir(top))
+    {
+      if(k->d_name[0] == '.') continue;
+      std::string keydir = fdir + "/" + k->d_name;
+      DIR* d = opendir(keydir.c_str());
+      if(!d) continue;
+      while(dirent* b = readdir(d))
+        {
+          if(b->d_name[0] == '.' || std::string(b->d_name) == "header") continue;
+          std::string p = keydir + "/" + b->d_name;
+          struct stat st;
+          if(stat(p.c_str(), &st) || !S_ISREG(st.st_mode)) continue;
+          total += st.st_size;
+          if(files) files->push_back(std::make_pair(st.st_mtime, std::make_pair((Long64_t)st.st_size, p)));
+        }
+      closedir(d);
+    }
+  closedir(top);
+  return total;
+}
+
+inline void mytmva::BlockCache::shrink()
+{
+  std::lock_guard<std::mutex> lock(fshrinkmutex);
+  // other processes may have added or removed blocks meanwhile
+  std::vector<std::pair<time_t, std::pair<Long64_t, std::string>>> files;
+  Long64_t total = scan(&files);
+  std::sort(files.begin(), files.end());
+  // down to 90% of the limit, so the next blocks do not trigger a scan each
+  for(std::size_t i=0; i<files.size() && total > 0.9*fmaxbytes; i++)
+    {
+      if(!unlink(files[i].second.second.c_str())) total -= files[i].second.first;
+    }
+  fbytes = total;
+}
+
+inline bool mytmva::BlockCache::has(const std::string& key, Long64_t iblock, Int_t len) const
+{
+  struct stat st;
+  return !stat(path(key, iblock).c_str(), &st) && st.st_size == len;
+}
+
+inline bool mytmva::BlockCache::read(const std::string& key, Long64_t iblock, char* buf, Int_t len)
+{
+  std::string p = path(key, iblock);
+  int fd = open(p.c_str(), O_RDONLY);
+  if(fd < 0) return false;
+  Int_t n = 0;
+  ssize_t r;
+  while(n < len && (r = ::read(fd, buf + n, len - n)) > 0) { n += r; }
+  // one byte more would mean a block of another size
+  char extra;
+  bool ok = n == len && ::read(fd, &extra, 1) == 0;
+  close(fd);
+  // the modification time orders the blocks for the removal
+  if(ok) utime(p.c_str(), 0);
+  return ok;
+}
+
+inline bool mytmva::BlockCache::writefile(const std::string& p, const char* buf, Int_t len) const
+{
+  std::ostringstream tmp;
+  tmp << p << ".tmp" << gSystem->GetPid() << "_" << std::this_thread::get_id();
+  {
+    std::ofstream out(tmp.str(), std::ios::binary);
+    if(!out.write(buf, len)) { unlink(tmp.str().c_str()); return false; }
+  }
+  if(std::rename(tmp.str().c_str(), p.c_str())) { unlink(tmp.str().c_str()); return false; }
+  return true;
+}
+
+inline void mytmva::BlockCache::write(const std::string& key, Long64_t iblock, const char* buf, Int_t len)
+{
+  gSystem->mkdir((fdir + "/" + key).c_str(), true);
+  if(!writefile(path(key, iblock), buf, len)) return;
+  if((fbytes += len) > fmaxbytes) shrink();
+}
+
+inline void mytmva::BlockCache::invalidate(const std::string& key)
+{
+  std::string keydir = fdir + "/" + key;
+  DIR* d = opendir(keydir.c_str());
+  if(!d) return;
+  while(dirent* b = readdir(d))
+    {
+      if(b->d_name[0] == '.' || std::string(b->d_name) == "header") continue;
+      std::string p = keydir + "/" + b->d_name;
+      struct stat st;
+      if(!stat(p.c_str(), &st) && !unlink(p.c_str())) fbytes -= st.st_size;
+    }
+  closedir(d);
+}
+
+inline bool mytmva::BlockCache::checkheader(const std::string& key, const std::vector<char>& header)
+{
+  std::string p = headerpath(key);
+  std::ifstream in(p, std::ios::binary);
+  std::string old((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  if(in.is_open() && old == std::string(header.begin(), header.end())) return true;
+  // also blocks without a header, which cannot be checked
+  invalidate(key);
+  gSystem->mkdir((fdir + "/" + key).c_str(), true);
+  writefile(p, header.data(), header.size());
+  return !in.is_open();
+}
+
+//
+
+inline mytmva::CachedFile::CachedFile(std::string url, BlockCache* cache, Long64_t readahead) :
+  TFile(url.c_str(), "NET"), fbackend(0), fprefetchbackend(0), fcache(cache), fsize(0), foffset(0), fblocksize(cache->blocksize()),
+  fahead(std::max(1LL, readahead/cache->blocksize())), fcurrent(-1), fdemand(0), fstop(false),
+  fnhit(0), fnfetch(0), ffetchbytes(0), ffetchtime(0)
+{
+  fOption = "READ";
+  fWritable = kFALSE;
+  fD = -1;
+  std::string raw = url + (url.find('?') == std::string::npos ? "?" : "&") + "filetype=raw";
+  fbackend = TFile::Open(raw.c_str());
+  if(!fbackend || fbackend->IsZombie()) { std::cout << "==> Abort " << __FUNCTION__ << ": error: cannot open " << url << "." << std::endl; MakeZombie(); gDirectory = gROOT; return; }
+  fsize = fbackend->GetSize();
+  FileStat_t st;
+  Long_t mtime = gSystem->GetPathInfo(url.c_str(), st) ? 0 : st.fMtime;
+
+  std::string id = url + "\n" + std::to_string(fsize) + "\n" + std::to_string(mtime);
+  TMD5 md5;
+  md5.Update((const UChar_t*)id.data(), id.size());
+  md5.Final();
+  fkey = md5.AsString();
+
+  // a file rewritten with the same size (and a modification time the server does not report) has a new UUID
+  Int_t nhead = std::min((Long64_t)100, fsize);
+  std::vector<char> head(nhead);
+  if(fbackend->ReadBuffer(&head[0], 0, nhead)) { MakeZombie(); gDirectory = gROOT; return; }
+  if(!fcache->checkheader(fkey, head)) std::cout << "==> " << __FUNCTION__ << ": " << url << " changed, dropped its cached blocks" << std::endl;
+
+  // the base class only sees this descriptor through the Sys* functions
+  fD = open("/dev/null", O_RDONLY);
+  Init(kFALSE);
+  cd();
+}
+
+inline mytmva::CachedFile::~CachedFile()
+{
+  {
+    std::lock_guard<std::mutex> lock(fmutex);
+    fstop = true;
+  }
+  fcv.notify_all();
+  if(fthread.joinable()) fthread.join();
+  // before ~TFile, which would close fD with the base class SysClose
+  Close();
+  if(fbackend) { fbackend->Close(); delete fbackend; }
+  if(fprefetchbackend) { fprefetchbackend->Close(); delete fprefetchbackend; }
+}
+
+inline Int_t mytmva::CachedFile::SysOpen(const char*, Int_t, UInt_t) { return -1; }
+
+inline Int_t mytmva::CachedFile::SysClose(Int_t fd) { return fd < 0 ? 0 : close(fd); }
+
+inline Int_t mytmva::CachedFile::SysWrite(Int_t, const void*, Int_t) { return -1; }
+
+inline Int_t mytmva::CachedFile::SysSync(Int_t) { return 0; }
+
+inline Long64_t mytmva::CachedFile::SysSeek(Int_t, Long64_t offset, Int_t whence)
+{
+  if(whence == SEEK_SET) foffset = offset;
+  else if(whence == SEEK_CUR) foffset += offset;
+  else if(whence == SEEK_END) foffset = fsize + offset;
+  return foffset;
+}
+
+inline Int_t mytmva::CachedFile::SysStat(Int_t, Long_t* id, Long64_t* size, Long_t* flags, Long_t* modtime)
+{
+  *id = 0;
+  *size = fsize;
+  *flags = 0;
+  *modtime = 0;
+  return 0;
+}
+
+inline Int_t mytmva::CachedFile::SysRead(Int_t, void* buf, Int_t len)
+{
+  Int_t done = 0;
+  while(done < len && foffset < fsize)
+    {
+      Long64_t iblock = foffset/fblocksize;
+      if(!load(iblock)) return -1;
+      Int_t offset = foffset - iblock*fblocksize;
+      Int_t n = std::min(len - done, blocklen(iblock) - offset);
+      std::memcpy((char*)buf + done, &fbuffer[offset], n);
+      done += n;
+      foffset += n;
+    }
+  return done;
+}
+
+inline void mytmva::CachedFile::addfetch(Long64_t nblocks, Long64_t bytes, std::chrono::steady_clock::time_point start)
+{
+  double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  double old = ffetchtime;
+  while(!ffetchtime.compare_exchange_weak(old, old + t)) { ; }
+  fnfetch += nblocks;
+  ffetchbytes += bytes;
+}
+
+inline bool mytmva::CachedFile::fetch(Long64_t iblock, char* buf)
+{
+  auto start = std::chrono::steady_clock::now();
+  if(fbackend->ReadBuffer(buf, iblock*fblocksize, blocklen(iblock))) return false;
+  addfetch(1, blocklen(iblock), start);
+  fcache->write(fkey, iblock, buf, blocklen(iblock));
+  return true;
+}
+
+inline bool mytmva::CachedFile::fetch(const std::vector<Long64_t>& blocks, char* buf)
+{
+  std::vector<Long64_t> pos;
+  std::vector<Int_t> len;
+  Long64_t bytes = 0;
+  for(auto& b : blocks)
+    {
+      pos.push_back(b*fblocksize);
+      len.push_back(blocklen(b));
+      bytes += len.back();
+    }
+  auto start = std::chrono::steady_clock::now();
+  // the blocks follow each other in buf
+  if(fprefetchbackend->ReadBuffers(buf, &pos[0], &len[0], blocks.size())) return false;
+  addfetch(blocks.size(), bytes, start);
+  Long64_t offset = 0;
+  for(std::size_t i=0; i<blocks.size(); i++)
+    {
+      fcache->write(fkey, blocks[i], buf + offset, len[i]);
+      offset += len[i];
+    }
+  return true;
+}
+
+// block iblock into fbuffer, waiting for the read-ahead when it is fetching it
+inline bool mytmva::CachedFile::load(Long64_t iblock)
+{
+  if(fcurrent == iblock) return true;
+  fbuffer.resize(fblocksize);
+  fcurrent = -1;
+  Int_t len = blocklen(iblock);
+  while(true)
+    {
+      {
+        std::unique_lock<std::mutex> lock(fmutex);
+        fdemand = iblock;
+        fcv.notify_all();
+        fcv.wait(lock, [this, iblock] { return !finflight.count(iblock); });
+      }
+      if(fcache->read(fkey, iblock, &fbuffer[0], len)) { fnhit++; fcurrent = iblock; return true; }
+      std::lock_guard<std::mutex> lock(fmutex);
+      // the read-ahead may have started or finished it meanwhile
+      if(finflight.count(iblock) || fcache->has(fkey, iblock, len)) continue;
+      finflight.insert(iblock);
+      break;
+    }
+  bool ok = fetch(iblock, &fbuffer[0]);
+  {
+    std::lock_guard<std::mutex> lock(fmutex);
+    finflight.erase(iblock);
+  }
+  fcv.notify_all();
+  if(!ok) { std::cout << "==> Abort " << __FUNCTION__ << ": error: cannot read block " << iblock << " of " << GetName() << "." << std::endl; return false; }
+  fcurrent = iblock;
+  return true;
+}
+
+inline void mytmva::CachedFile::prefetch(const std::vector<std::pair<Long64_t, Long64_t>>& ranges)
+{
+  std::set<Long64_t> blocks;
+  for(auto& r : ranges)
+    {
+      for(Long64_t b = r.first/fblocksize; b <= (r.second-1)/fblocksize && b*fblocksize < fsize; b++) { blocks.insert(b); }
+    }
+  {
+    std::lock_guard<std::mutex> lock(fmutex);
+    // the new ranges replace those not fetched yet, and the reader is about to start at the first one
+    fqueue.assign(blocks.begin(), blocks.end());
+    if(!blocks.empty()) fdemand = *blocks.begin();
+    if(!fthread.joinable())
+      {
+        // opened here rather than in the read-ahead thread, which must not change gDirectory
+        TDirectory* save = gDirectory;
+        std::string raw = std::string(GetName()) + (std::string(GetName()).find('?') == std::string::npos ? "?" : "&") + "filetype=raw";
+        fprefetchbackend = TFile::Open(raw.c_str());
+        save->cd();
+        if(!fprefetchbackend || fprefetchbackend->IsZombie())
+          {
+            std::cout << "==> " << __FUNCTION__ << ": warning: cannot open " << GetName() << " for the read-ahead, reading on demand only." << std::endl;
+            delete fprefetchbackend;
+            fprefetchbackend = 0;
+            fqueue.clear();
+            return;
+          }
+        fthread = std::thread(&CachedFile::loop, this);
+      }
+  }
+  fcv.notify_all();
+}
+
+inline void mytmva::CachedFile::loop()
+{
+  // blocks per vector read
+  const std::size_t nbatch = 16;
+  std::vector<char> buf(nbatch*fblocksize);
+  std::vector<Long64_t> batch;
+  std::unique_lock<std::mutex> lock(fmutex);
+  while(true)
+    {
+      fcv.wait(lock, [this] { return fstop || (!fqueue.empty() && fqueue.front() <= fdemand + fahead); });
+      if(fstop) return;
+      batch.clear();
+      while(!fqueue.empty() && batch.size() < nbatch && fqueue.front() <= fdemand + fahead)
+        {
+          Long64_t iblock = fqueue.front();
+          fqueue.pop_front();
+          // blocks the reader has already passed are in the cache or not needed any more
+          if(iblock < fdemand || finflight.count(iblock) || fcache->has(fkey, iblock, blocklen(iblock))) continue;
+          finflight.insert(iblock);
+          batch.push_back(iblock);
+        }
+      if(batch.empty()) continue;
+      lock.unlock();
+      bool ok = fetch(batch, &buf[0]);
+      lock.lock();
+      for(auto& b : batch) { finflight.erase(b); }
+      fcv.notify_all();
+      // the reader fetches the blocks itself
+      if(!ok) std::cout << "==> " << __FUNCTION__ << ": warning: read-ahead of " << batch.size() << " blocks of " << GetName() << " failed." << std::endl;
+    }
+}
+
+//
+
+inline std::vector<TBranch*> mytmva::activebranches(TTree* t)
+{
+  std::vector<TBranch*> branches;
+  std::vector<TObjArray*> lists(1, t->GetListOfBranches());
+  while(!lists.empty())
+    {
+      TObjArray* l = lists.back();
+      lists.pop_back();
+      for(int i=0; i<l->GetEntriesFast(); i++)
+        {
+          TBranch* b = (TBranch*)l->At(i);
+          if(b->TestBit(kDoNotProcess)) continue;
+          branches.push_back(b);
+          if(b->GetListOfBranches()->GetEntriesFast()) lists.push_back(b->GetListOfBranches());
+        }
+    }
+  return branches;
+}
+
+inline std::vector<std::pair<Long64_t, Long64_t>> mytmva::basketranges(const std::vector<TBranch*>& branches, Long64_t first, Long64_t last)
+{
+  std::vector<std::pair<Long64_t, Long64_t>> ranges;
+  for(auto& b : branches)
+    {
+      Long64_t* entry = b->GetBasketEntry();
+      Int_t* bytes = b->GetBasketBytes();
+      Int_t nbaskets = b->GetWriteBasket();
+      for(Int_t i=0; i<nbaskets; i++)
+        {
+          Long64_t end = i+1 < nbaskets ? entry[i+1] : b->GetEntries();
+          if(end <= first || entry[i] >= last || bytes[i] <= 0) continue;
+          Long64_t seek = b->GetBasketSeek(i);
+          if(seek > 0) ranges.push_back(std::make_pair(seek, seek + bytes[i]));
+        }
+    }
+  // the order in the file, which is about the order of the clusters
+  std::sort(ranges.begin(), ranges.end());
+  return ranges;
+}
+
+//
+
+inline mytmva::Uploader::Uploader(std::string dest, bool removelocal) : fdest(dest), fremovelocal(removelocal), fpending(0), fnfail(0), fstop(false)
+{
+  if(fdest != "" && fdest.back() != '/') fdest += "/";
+  fthread = std::thread(&Uploader::loop, this);
+}
+
+inline void mytmva::Uploader::add(std::string localfile)
+{
+  {
+    std::lock_guard<std::mutex> lock(fmutex);
+    fqueue.push_back(localfile);
+    fpending++;
+  }
+  fcv.notify_all();
+}
+
+inline int mytmva::Uploader::wait()
+{
+  std::unique_lock<std::mutex> lock(fmutex);
+  fcv.wait(lock, [this] { return fpending == 0; });
+  if(!fstop)
+    {
+      fstop = true;
+      fcv.notify_all();
+      lock.unlock();
+      fthread.join();
+      lock.lock();
+    }
+  return fnfail;
+}
+
+inline void mytmva::Uploader::loop()
+{
+  std::unique_lock<std::mutex> lock(fmutex);
+  while(true)
+    {
+      fcv.wait(lock, [this] { return fstop || !fqueue.empty(); });
+      if(fqueue.empty()) return;
+      std::string local = fqueue.front();
+      fqueue.pop_front();
+      lock.unlock();
+      std::string dest = fdest + gSystem->BaseName(local.c_str());
+      auto start = std::chrono::steady_clock::now();
+      bool ok = TFile::Cp(local.c_str(), dest.c_str(), kFALSE);
+      double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      if(ok) std::cout << "--- uploaded " << local << " to " << dest << " in " << elapsed << " s" << std::endl;
+      else std::cout << "==> " << __FUNCTION__ << ": error: cannot copy " << local << " to " << dest << ", it is kept." << std::endl;
+      if(ok && fremovelocal) gSystem->Unlink(local.c_str());
+      lock.lock();
+      if(!ok) fnfail++;
+      fpending--;
+      fcv.notify_all();
+    }
+}
+
+#endif
@@ -0,0 +1,375 @@
+#ifndef _TMVATRAINDATA_H_
+#define _TMVATRAINDATA_H_
+
+// Training input preparation shared by the pt bins of TMVAClassification.C.
+//
+// - addfriends : attach the friend trees of Dfinder/ntDkpi
+// - partition  : one pass over a tree that applies the preselection and splits the selected
+//                candidates by pt into in-memory trees, one per bin. The bin trees hold flat
+//                Float_t branches named after the branches referenced by the variable and
+//                spectator expressions, so the same expressions can be given to the DataLoader.
+// - cachedskim : the preselected candidates of one input tree, cached on disk as a flat TTree in
+//                cachedir/ and keyed by the tree, cut, expressions and input file identity. The first
+//                use builds it, later runs, stages and pt bins read the small skim instead.
+// - StreamLoader : reads trees entry by entry and keeps, within a memory budget shared by all trees, a
+//                  weighted reservoir subsample of each tree as flat float columns (WeightedSample),
+//                  with the weights rescaled so every tree keeps its weighted yield.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "TDirectory.h"
+#include "TFile.h"
+#include "TMD5.h"
+#include "TSystem.h"
+#include "TTree.h"
+#include "TTreeFormula.h"
+
+#include "TMVAAppIO.h"
+
+namespace mytmva
+{
+  const std::vector<std::string> friendtrees = {"hltanalysis/HltTree",
+                                                "hiEvtAnalyzer/HiTree",
+                                                "skimanalysis/HltTree",
+                                                "ppTracks/trackTree",
+                                                "l1MetFilterRecoTree/MetFilterRecoTree",
+                                                "zdcanalyzer/zdcdigi",
+                                                "particleFlowAnalyser/pftree"};
+
+  inline void addfriends(TTree* t)
+  {
+    for(auto& f : friendtrees) { t->AddFriend(f.c_str()); }
+  }
+
+  // value of instance i, scalar formulas give the same value for every instance (as in TMVA::DataSetFactory)
+  inline double evalinstance(TTreeFormula* f, int i) { return f->GetNdata() == 1 ? f->EvalInstance(0) : f->EvalInstance(i); }
+
+  // rows of the loaded entry: one per array element, scalar formulas are repeated in every row. All
+  // array-valued formulas must have the same length (as in TMVA::DataSetFactory), otherwise the error is
+  // printed for entry ievt and -1 returned
+  inline int ninstances(const std::vector<TTreeFormula*>& formulas, std::string name, Long64_t ievt)
+  {
+    int n = 1;
+    TTreeFormula* farray = 0;
+    for(auto& f : formulas)
+      {
+        int ndata = f->GetNdata();
+        if(ndata == 1) continue;
+        if(!farray) { farray = f; n = ndata; }
+        else if(ndata != n)
+          {
+            std::cout << "==> Abort " << __FUNCTION__ << ": error: " << name << ": arrays of different length in entry " << ievt << ": "
+                      << farray->GetTitle() << " has " << n << " values, " << f->GetTitle() << " has " << ndata << "." << std::endl;
+            return -1;
+          }
+      }
+    return n;
+  }
+
+  // ptedges: bin edges as in mytmva::ptbins, a negative upper edge means no upper limit;
+  //          with an empty ptvar all selected candidates go to a single tree
+  // computed: extra columns (name, expression), e.g. the event weight
+  // dir: directory the trees are created in, in memory if 0
+  // All array-valued formulas of an entry must have the same length (as in TMVA::DataSetFactory); otherwise
+  // the error is printed and no trees are returned
+  inline std::vector<TTree*> partition(TTree* t, std::string cut, const std::vector<std::string>& exprs,
+                                std::string ptvar, const std::vector<float>& ptedges, std::string name,
+                                const std::vector<std::pair<std::string, std::string>>& computed = {}, TDirectory* dir = 0)
+  {
+    std::vector<std::string> columns = exprbranches(t, exprs);
+    std::vector<std::string> colexprs = columns;
+    for(auto& c : computed) { columns.push_back(c.first); colexprs.push_back(c.second); }
+    TTreeFormula* fcut = new TTreeFormula((name+"_cut").c_str(), cut.c_str(), t);
+    TTreeFormula* fpt = new TTreeFormula((name+"_pt").c_str(), ptvar == "" ? "0" : ptvar.c_str(), t);
+    std::vector<TTreeFormula*> fcol;
+    for(std::size_t c=0; c<columns.size(); c++) { fcol.push_back(new TTreeFormula((name+"_"+columns[c]).c_str(), colexprs[c].c_str(), t)); }
+
+    std::vector<float> edges = ptvar == "" ? std::vector<float>{-1.e+10, -1} : ptedges;
+    std::vector<Float_t> val(columns.size());
+    std::vector<TTree*> bins;
+    for(std::size_t ib=0; ib+1<edges.size(); ib++)
+      {
+        TTree* b = new TTree(ptvar == "" ? name.c_str() : Form("%s_%d", name.c_str(), (int)ib),
+                             Form("%s, %s in bin %d", name.c_str(), ptvar.c_str(), (int)ib));
+        b->SetDirectory(dir);
+        for(std::size_t c=0; c<columns.size(); c++) { b->Branch(columns[c].c_str(), &val[c], (columns[c]+"/F").c_str()); }
+        bins.push_back(b);
+      }
+
+    std::vector<TTreeFormula*> fall = {fcut, fpt};
+    fall.insert(fall.end(), fcol.begin(), fcol.end());
+    auto cleanup = [&]()
+      {
+        delete fcut;
+        delete fpt;
+        for(auto& f : fcol) { delete f; }
+      };
+
+    Long64_t nentries = t->GetEntries(), nsel = 0;
+    std::cout << "==> " << __FUNCTION__ << ": " << name << ": " << nentries << " entries, " << columns.size() << " columns, " << bins.size() << " bins" << std::endl;
+    for(Long64_t ievt=0; ievt<nentries; ievt++)
+      {
+        if(t->LoadTree(ievt) < 0) break;
+        int n = ninstances(fall, name, ievt);
+        if(n < 0)
+          {
+            cleanup();
+            for(auto& b : bins) { delete b; }
+            return std::vector<TTree*>();
+          }
+        for(int i=0; i<n; i++)
+          {
+            if(!evalinstance(fcut, i)) continue;
+            double pt = evalinstance(fpt, i);
+            for(std::size_t ib=0; ib<bins.size(); ib++)
+              {
+                if(!(pt > edges[ib] && (edges[ib+1] < 0 || pt < edges[ib+1]))) continue;
+                for(std::size_t c=0; c<fcol.size(); c++) { val[c] = evalinstance(fcol[c], i); }
+                bins[ib]->Fill();
+                nsel++;
+              }
+          }
+      }
+    std::cout << "==> " << __FUNCTION__ << ": " << name << ": " << nsel << " candidates selected" << std::endl;
+
+    cleanup();
+    return bins;
+  }
+
+  // treename is read from filename with the given friends attached; the returned tree is
+  // "skim" in the cache file, which stays open and is owned by the caller: delete tree->GetDirectory()
+  // when done with the tree
+  inline TTree* cachedskim(std::string filename, std::string treename, std::string cut, const std::vector<std::string>& exprs,
+                    const std::vector<std::pair<std::string, std::string>>& computed = {},
+                    const std::vector<std::string>& friends = {}, std::string cachedir = "skimcache")
+  {
+    TFile* inf = TFile::Open(filename.c_str());
+    if(!inf || inf->IsZombie()) { std::cout << "==> Abort " << __FUNCTION__ << ": error: cannot open " << filename << std::endl; return 0; }
+
+    // key: what is selected and stored, and which file it comes from (UUID changes whenever the file is rewritten)
+    std::string key = treename + "\n" + cut;
+    for(auto& e : exprs) { key += "\n" + e; }
+    for(auto& c : computed) { key += "\n" + c.first + "=" + c.second; }
+    for(auto& f : friends) { key += "\n+" + f; }
+    key += Form("\n%s\n%lld", inf->GetUUID().AsString(), inf->GetSize());
+    TMD5 md5;
+    md5.Update((const UChar_t*)key.data(), key.size());
+    md5.Final();
+    TString base = gSystem->BaseName(filename.c_str());
+    base.ReplaceAll(".root", "");
+    std::string cachename = cachedir + "/" + base.Data() + "_" + md5.AsString() + ".root";
+
+    if(gSystem->AccessPathName(cachename.c_str()))
+      {
+        std::cout << "==> " << __FUNCTION__ << ": building " << cachename << " from " << filename << std::endl;
+        TTree* t = (TTree*)inf->Get(treename.c_str());
+        if(!t) { std::cout << "==> Abort " << __FUNCTION__ << ": error: no " << treename << " in " << filename << std::endl; delete inf; return 0; }
+        for(auto& f : friends) { t->AddFriend(f.c_str()); }
+        gSystem->mkdir(cachedir.c_str(), true);
+        // written under a temporary name and renamed, so an interrupted or concurrent build never leaves a partial cache
+        std::string tmpname = cachename + Form(".tmp%d", gSystem->GetPid());
+        TFile* outf = TFile::Open(tmpname.c_str(), "RECREATE");
+        if(!outf || outf->IsZombie()) { std::cout << "==> Abort " << __FUNCTION__ << ": error: cannot write " << tmpname << std::endl; delete outf; delete inf; return 0; }
+        std::vector<TTree*> skims = partition(t, cut, exprs, "", {}, "skim", computed, outf);
+        if(skims.empty())
+          {
+            delete outf;
+            gSystem->Unlink(tmpname.c_str());
+            delete inf;
+            return 0;
+          }
+        TTree* skim = skims[0];
+        outf->cd();
+        skim->Write();
+        outf->Close();
+        // the skim tree belongs to outf and goes with it
+        delete outf;
+        gSystem->Rename(tmpname.c_str(), cachename.c_str());
+      }
+    else
+      { std::cout << "==> " << __FUNCTION__ << ": using " << cachename << " for " << filename << std::endl; }
+    inf->Close();
+    delete inf;
+
+    TFile* cachef = TFile::Open(cachename.c_str());
+    TTree* skim = cachef ? (TTree*)cachef->Get("skim") : 0;
+    if(!skim) { std::cout << "==> Abort " << __FUNCTION__ << ": error: no skim in " << cachename << std::endl; delete cachef; }
+    return skim;
+  }
+
+  // skim with the event weight stored in the column "weight", for trainBDT.py
+  inline TTree* cachedskim(std::string filename, std::string treename, std::string cut, const std::vector<std::string>& exprs, std::string weightexpr)
+  {
+    return cachedskim(filename, treename, cut, exprs, {std::make_pair(std::string("weight"), weightexpr)});
+  }
+  // Weighted reservoir subsample of one tree (Efraimidis-Spirakis: the capacity events with the
+  // largest log(u)/|w| are kept). If the tree has more selected events than the capacity, the kept
+  // events get weight sign(w)*sum|w|/k, scaled so that their sum is the tree's sum of weights.
+  // Array-valued expressions give one event per element, as in partition and TMVA::DataSetFactory.
+  // Events of zero weight count in nselected and yield but are never kept, they do not change the
+  // training.
+  class WeightedSample
+  {
+  public:
+    WeightedSample(TTree* t, const std::vector<std::string>& exprs, std::string cut, std::string weightexpr, double treeweight,
+                   std::size_t capacity, unsigned int seed);
+    // false when the arrays of an entry differ in length, the sample is then incomplete
+    bool isvalid() const { return fvalid; }
+    std::size_t size() const { return fweight.size(); }
+    Long64_t nselected() const { return fnselected; }
+    double yield() const { return fyield; }
+    // flat tree with the referenced branches and "weight"; the buffers are released into it
+    TTree* tree(std::string name);
+
+  private:
+    std::vector<std::string> fcolumns;
+    std::vector<std::vector<float>> fdata; // [column][event]
+    std::vector<float> fweight;
+    bool fvalid;
+    Long64_t fnselected;
+    double fyield;
+  };
+
+  // shares a memory budget (MB) between the trees added one after the other: each tree gets the remaining
+  // budget times its share of the remaining entries, so what small or tightly selected trees leave over
+  // goes to the later ones
+  class StreamLoader
+  {
+  public:
+    StreamLoader(const std::vector<std::string>& exprs, double budgetmb, Long64_t totalentries, unsigned int seed = 1)
+      : fexprs(exprs), fbudget(budgetmb*1024*1024), fremaining(totalentries), fseed(seed) { }
+    // 0 when the tree cannot be sampled
+    WeightedSample* add(TTree* t, double treeweight, std::string weightexpr = "weight", std::string cut = "")
+    {
+      // per kept event: the columns and the weight as floats, twice while WeightedSample::tree copies them,
+      // and the reservoir entry (key and slot)
+      std::size_t ncol = exprbranches(t, fexprs).size();
+      double perevent = 2*(ncol+1)*sizeof(float) + sizeof(std::pair<double, uint32_t>);
+      Long64_t nentries = t->GetEntries();
+      double share = fremaining > 0 ? std::min(1., (double)nentries/fremaining) : 1.;
+      std::size_t capacity = std::max(1., fbudget*share/perevent);
+      WeightedSample* s = new WeightedSample(t, fexprs, cut, weightexpr, treeweight, capacity, fseed++);
+      if(!s->isvalid()) { delete s; return 0; }
+      fbudget = std::max(0., fbudget - s->size()*perevent);
+      fremaining -= nentries;
+      return s;
+    }
+
+  private:
+    std::vector<std::string> fexprs;
+    double fbudget;
+    Long64_t fremaining;
+    unsigned int fseed;
+  };
+}
+
+inline mytmva::WeightedSample::WeightedSample(TTree* t, const std::vector<std::string>& exprs, std::string cut, std::string weightexpr,
+                                       double treeweight, std::size_t capacity, unsigned int seed) : fvalid(true), fnselected(0), fyield(0)
+{
+  fcolumns = exprbranches(t, exprs);
+  std::vector<TTreeFormula*> fcol;
+  for(auto& c : fcolumns) { fcol.push_back(new TTreeFormula(("sample_"+c).c_str(), c.c_str(), t)); }
+  TTreeFormula* fcut = new TTreeFormula("sample_cut", cut == "" ? "1" : cut.c_str(), t);
+  TTreeFormula* fw = new TTreeFormula("sample_weight", weightexpr == "" ? "1" : weightexpr.c_str(), t);
+  // only the baskets of the needed branches go through a bounded read cache
+  t->SetCacheSize(32*1024*1024);
+  for(auto& c : fcolumns) { t->AddBranchToCache(c.c_str(), true); }
+
+  std::vector<TTreeFormula*> fall = {fcut, fw};
+  fall.insert(fall.end(), fcol.begin(), fcol.end());
+
+  // reserved up front, so the vectors never hold twice the capacity while growing
+  Long64_t nentries = t->GetEntries();
+  std::size_t nreserve = std::min<Long64_t>(capacity, nentries);
+  fdata.assign(fcolumns.size(), std::vector<float>());
+  for(auto& d : fdata) d.reserve(nreserve);
+  fweight.reserve(nreserve);
+  std::vector<std::pair<double, uint32_t>> heap;
+  heap.reserve(nreserve);
+  std::priority_queue<std::pair<double, uint32_t>, std::vector<std::pair<double, uint32_t>>, std::greater<std::pair<double, uint32_t>>>
+    reservoir(std::greater<std::pair<double, uint32_t>>(), std::move(heap));
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> uniform(0, 1);
+  double sumabs = 0;
+  Long64_t nonzero = 0;
+  for(Long64_t ievt=0; ievt<nentries && fvalid; ievt++)
+    {
+      if(t->LoadTree(ievt) < 0) break;
+      int n = ninstances(fall, t->GetName(), ievt);
+      if(n < 0) { fvalid = false; break; }
+      for(int i=0; i<n; i++)
+        {
+          if(!evalinstance(fcut, i)) continue;
+          double w = treeweight*evalinstance(fw, i);
+          fnselected++;
+          fyield += w;
+          if(w == 0) continue;
+          sumabs += std::fabs(w);
+          nonzero++;
+          double key = std::log(1. - uniform(rng))/std::fabs(w);
+          uint32_t slot;
+          if(fweight.size() < capacity)
+            {
+              slot = fweight.size();
+              fweight.push_back(0);
+              for(auto& d : fdata) d.push_back(0);
+            }
+          else if(key > reservoir.top().first)
+            {
+              slot = reservoir.top().second;
+              reservoir.pop();
+            }
+          else continue;
+          reservoir.push(std::make_pair(key, slot));
+          fweight[slot] = w;
+          for(std::size_t c=0; c<fcol.size(); c++) { fdata[c][slot] = evalinstance(fcol[c], i); }
+        }
+    }
+  // the reservation may exceed what was selected
+  for(auto& d : fdata) d.shrink_to_fit();
+  fweight.shrink_to_fit();
+
+  if((Long64_t)fweight.size() < nonzero)
+    {
+      double sum = 0;
+      for(auto& w : fweight) { w = (w > 0 ? 1 : -1) * sumabs/fweight.size(); sum += w; }
+      if(sum != 0 && sum*fyield > 0) { for(auto& w : fweight) w *= fyield/sum; }
+      else { std::cout << "==> " << __FUNCTION__ << ": warning: subsample of " << t->GetName() << " cannot keep the sum of weights " << fyield << std::endl; }
+    }
+  std::cout << "==> " << __FUNCTION__ << ": " << t->GetName() << ": " << fnselected << " selected, " << fweight.size() << " kept, sum of weights " << fyield << std::endl;
+
+  t->SetCacheSize(0);
+  for(auto& f : fcol) { delete f; }
+  delete fcut;
+  delete fw;
+}
+
+inline TTree* mytmva::WeightedSample::tree(std::string name)
+{
+  TTree* t = new TTree(name.c_str(), "weighted subsample");
+  t->SetDirectory(0);
+  std::vector<Float_t> val(fcolumns.size());
+  Float_t weight;
+  for(std::size_t c=0; c<fcolumns.size(); c++) { t->Branch(fcolumns[c].c_str(), &val[c], (fcolumns[c]+"/F").c_str()); }
+  t->Branch("weight", &weight, "weight/F");
+  for(std::size_t i=0; i<fweight.size(); i++)
+    {
+      for(std::size_t c=0; c<fcolumns.size(); c++) { val[c] = fdata[c][i]; }
+      weight = fweight[i];
+      t->Fill();
+    }
+  t->ResetBranchAddresses();
+  std::vector<std::vector<float>>().swap(fdata);
+  std::vector<float>().swap(fweight);
+  return t;
+}
+
+#endif
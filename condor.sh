@@ -9,20 +9,36 @@ cd CMSSW_9_0_1/src/
 echo "PWD = "$PWD
 eval `scramv1 runtime -sh` # cmsenv is an alias not on the workers
 echo "CMSSW: "$CMSSW_BASE
-xrdcp  root://cmseos.fnal.gov//store/user/rasharma/TMVA/Trial1/TMVAClassification.C .
-xrdcp  root://cmseos.fnal.gov//store/user/rasharma/TMVA/Trial1/TMVAClassificationApplication.C .
-xrdcp  root://cmseos.fnal.gov//store/user/rasharma/TMVA/Trial1/RunAllFiles.py .
+# the copies run in parallel
+for FILE in TMVAClassification.C TMVAClassificationApplication.C RunAllFiles.py TMVAApplicationDriver.C TMVAForest.h TMVAAppIO.h TMVAProfile.h TMVARemoteIO.h
+do
+  xrdcp -f root://cmseos.fnal.gov//store/user/rasharma/TMVA/Trial1/${FILE} . &
+done
+wait
+# remote ntuples are read through a local block cache with read-ahead (TMVARemoteIO.h). The cache has to
+# outlive the job to serve the next runs over the same samples, so it is not the job scratch directory but
+# a directory of the worker node given in condor.jdl; without it the inputs are read directly
+if [ -n "${TMVA_CACHEDIR}" ] && mkdir -p ${TMVA_CACHEDIR}; then
+  export TMVA_CACHEDIR
+  export TMVA_CACHEMB=${TMVA_CACHEMB:-4000}
+  echo "Block cache: ${TMVA_CACHEDIR}, at most ${TMVA_CACHEMB} MB"
+else
+  unset TMVA_CACHEDIR
+  echo "No block cache, reading the inputs directly"
+fi
+OUTDIR=root://cmseos.fnal.gov//store/user/rasharma/TMVA/Trial1/
 rm TraningOutput.dat ApplicationOutput.dat RunAll.dat
 echo "Start running TMVA Traning...."
 root -l -b -q TMVAClassification.C  | tee TraningOutput.dat
 echo "Start running TMVA Application Traning...."
 root -l -b -q TMVAClassificationApplication.C | tee ApplicationOutput.dat
 echo "Start running TMVA Application For all root files"
-python RunAllFiles.py >& RunAll.dat
+g++ -O2 TMVAApplicationDriver.C $(root-config --cflags --libs) -lTMVA -lXMLIO -lTreePlayer -o TMVAApplicationDriver
+# the outputs of the driver are copied to OUTDIR while the next files are processed
+python RunAllFiles.py $(nproc) ${OUTDIR} >& RunAll.dat
 echo "List all files"
 ls 
 echo "*******************************************"
-OUTDIR=root://cmseos.fnal.gov//store/user/rasharma/TMVA/Trial1/
 echo "xrdcp output for condor"
 for FILE in *
 do